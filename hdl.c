@@ -1,5 +1,6 @@
 #include "hdl.h"
 #include <string.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
@@ -37,44 +38,84 @@ const uint8_t TYPE_SIZES[] = {
     4, /* HDL_TYPE_I32 */
     2, /* HDL_TYPE_IMG */
     2, /* HDL_TYPE_BIND */
+    sizeof(struct HDL_Array), /* HDL_TYPE_ARRAY */
+    sizeof(struct HDL_Ring), /* HDL_TYPE_RING */
 };
 
 struct HDL_Bitmap *_hdl_getBitmap (struct HDL_Interface *interface, uint16_t id);
 
-struct HDL_Interface HDL_CreateInterface (uint16_t width, uint16_t height, enum HDL_ColorSpace colorSpace, int features) {
-    struct HDL_Interface interface;
+// Returns the description of an element
+const struct HDL_ElementDesc *_hdl_desc (struct HDL_Interface *interface, const struct HDL_Element *element) {
+    return &interface->elementDesc[element - interface->elements];
+}
+
+// Returns the description of an element for writing. Only used by HDL_Build, restored tables may be resident
+struct HDL_ElementDesc *_hdl_buildDesc (struct HDL_Interface *interface, const struct HDL_Element *element) {
+    return (struct HDL_ElementDesc*)&interface->elementDesc[element - interface->elements];
+}
+
+// Returns the element extension, NULL if the element has none
+struct HDL_ElementExt *_hdl_getExt (struct HDL_Interface *interface, const struct HDL_Element *element) {
+    return element->ext != HDL_NO_EXT ? &interface->elementExt[element->ext] : NULL;
+}
+
+// Returns the attributes of an element, with bound values if it has bound attributes
+const struct HDL_Attrs *_hdl_attrs (struct HDL_Interface *interface, const struct HDL_Element *element) {
+    if(element->ext != HDL_NO_EXT && interface->elementExt[element->ext].attrs != NULL)
+        return interface->elementExt[element->ext].attrs;
+    return &_hdl_desc(interface, element)->attrs;
+}
+uint8_t *_hdl_getBitmapData (struct HDL_Interface *interface, struct HDL_Bitmap *bmp);
+void _hdl_resolveElement (struct HDL_Interface *interface, struct HDL_Element *element);
+void _hdl_resolveRefs (struct HDL_Interface *interface);
+void _hdl_updateDeadline (struct HDL_Interface *interface);
+void _hdl_hideSubtree (struct HDL_Interface *interface, struct HDL_Element *element);
+void _hdl_hitMoved (struct HDL_Interface *interface, struct HDL_Element *element);
+
+void HDL_InitInterface (struct HDL_Interface *interface, uint16_t width, uint16_t height, enum HDL_ColorSpace colorSpace, int features) {
     // Zero interface values
-    memset(&interface, 0, sizeof(struct HDL_Interface));
+    memset(interface, 0, sizeof(struct HDL_Interface));
 
     // Set parameters
-    interface.width = width;
-    interface.height = height;
-    interface.colorSpace = colorSpace;
-    interface.features = features;
+    interface->width = width;
+    interface->height = height;
+    interface->colorSpace = colorSpace;
+    interface->features = features;
     // Default text width and height
-    interface.textWidth = 8;
-    interface.textHeight = 8;
+    interface->textWidth = 8;
+    interface->textHeight = 8;
     // Default update rates
     // Never force update
-    interface.maxUpdateInterval = 0;
+    interface->maxUpdateInterval = 0;
     // Allow updates only every 30ms
-    interface.minUpdateInterval = 30;
+    interface->minUpdateInterval = 30;
+
+    // Driver color is set on first draw
+    interface->_color = HDL_COLOR_UNKNOWN;
+    interface->foreground = 0xFFFFFF;
+
+    // Lazy bitmaps
+    interface->bitmapBudget = HDL_CONF_BITMAP_CACHE_SIZE;
 
     // Preloaded images
-    interface.bitmapCount_pl = 0;
+    interface->bitmapCount_pl = 0;
 
     for(int i = 0; i < HDL_CONF_MAX_PRELOADED_IMAGES; i++) {
-        interface.bitmaps_pl[i].id = 0xFFFF;
+        interface->bitmaps_pl[i].id = 0xFFFF;
     }
 
     // Reset bindings
     for(int i = 0; i < HDL_CONF_MAX_BINDINGS; i++) {
-        interface.bindings[i].id = 0xFFFF;
+        interface->bindings[i].id = 0xFFFF;
         #ifdef HDL_CONF_BIND_COPIES
-        interface._bindings_cpy->id = 0xFFFF;
+        interface->_bindings_cpy->id = 0xFFFF;
         #endif
     }
+}
 
+struct HDL_Interface HDL_CreateInterface (uint16_t width, uint16_t height, enum HDL_ColorSpace colorSpace, int features) {
+    struct HDL_Interface interface;
+    HDL_InitInterface(&interface, width, height, colorSpace, features);
     return interface;
 }
 
@@ -85,95 +126,197 @@ int _hdl_is_format_spec (char c) {
             c == 's';
 }
 
+// Core font data
+struct _hdl_Font {
+    struct HDL_Bitmap *bmp;
+    const struct HDL_FontHeader *header;
+    const struct HDL_Glyph *glyphs;
+    const struct HDL_Kerning *kerning;
+    const uint8_t *atlas;
+    uint16_t rowBytes;
+};
+
+// Opens font data of a bitmap. Returns 0 if the font is valid
+int _hdl_openFont (struct HDL_Interface *interface, struct HDL_Bitmap *bmp, struct _hdl_Font *font) {
+    if(bmp == NULL || (bmp->colorMode & 0x0F) != HDL_BITMAP_FONT || bmp->size < sizeof(struct HDL_FontHeader))
+        return 1;
+
+    const uint8_t *data = _hdl_getBitmapData(interface, bmp);
+    if(data == NULL)
+        return 1;
+
+    const struct HDL_FontHeader *header = (const struct HDL_FontHeader*)data;
+    uint16_t rowBytes = (header->atlasWidth + 7) / 8;
+    uint32_t size = sizeof(struct HDL_FontHeader) + 
+        header->count * sizeof(struct HDL_Glyph) + 
+        header->kernCount * sizeof(struct HDL_Kerning) + 
+        (uint32_t)rowBytes * header->height;
+
+    if(size > bmp->size)
+        return 1;
+
+    font->bmp = bmp;
+    font->header = header;
+    font->glyphs = (const struct HDL_Glyph*)(data + sizeof(struct HDL_FontHeader));
+    font->kerning = (const struct HDL_Kerning*)(font->glyphs + header->count);
+    font->atlas = (const uint8_t*)(font->kerning + header->kernCount);
+    font->rowBytes = rowBytes;
+    return 0;
+}
+
+// Returns the glyph of a character, NULL if the font has none
+const struct HDL_Glyph *_hdl_fontGlyph (const struct _hdl_Font *font, uint8_t c) {
+    if(c < font->header->first || c - font->header->first >= font->header->count)
+        return NULL;
+    return &font->glyphs[c - font->header->first];
+}
+
+// Returns the kerning of a character pair
+int8_t _hdl_fontKerning (const struct _hdl_Font *font, uint8_t left, uint8_t right) {
+    uint16_t key = ((uint16_t)left << 8) | right;
+    int lo = 0;
+    int hi = font->header->kernCount - 1;
+
+    // Pairs are sorted
+    while(lo <= hi) {
+        int mid = (lo + hi) / 2;
+        uint16_t pair = ((uint16_t)font->kerning[mid].left << 8) | font->kerning[mid].right;
+        if(pair == key)
+            return font->kerning[mid].adjust;
+        if(pair < key)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return 0;
+}
+
 /**
- * @brief Get string width and height with newlines
+ * @brief Get string width and height with newlines, in pixels at size 1. 
+ * Core fonts are measured by glyph advance and kerning, otherwise by the driver text cell
  * 
+ * @param interface 
+ * @param font Core font or NULL
  * @param str 
  * @return int 
  */
-int _hdl_str_size (char *str, uint16_t *w, uint16_t *h) {
-    *w = 0;
-    *h = 1;
+int _hdl_str_size (struct HDL_Interface *interface, const struct _hdl_Font *font, char *str, uint16_t *w, uint16_t *h) {
+    uint16_t lineHeight = font != NULL ? font->header->height + 1 : interface->textHeight + 1;
+    uint16_t lines = 1;
     int lw = 0;
-    for(int i = 0; i < strlen(str); i++) {
-        if(str[i] != '\n') {
-            lw++;
+
+    *w = 0;
+    for(const uint8_t *c = (const uint8_t*)str; *c; c++) {
+        if(*c != '\n') {
+            if(font == NULL) {
+                lw += interface->textWidth + 1;
+            }
+            else {
+                const struct HDL_Glyph *glyph = _hdl_fontGlyph(font, *c);
+                if(glyph != NULL)
+                    lw += glyph->advance + _hdl_fontKerning(font, c[0], c[1]);
+            }
         }
         else {
             if(lw > *w) {
                 *w = lw;
             }
             lw = 0;
-            (*h)++;
+            lines++;
         }
     }
     if(lw > *w) {
         *w = lw;
     }
+    *h = lines * lineHeight;
 
     return 0;
 }
 
-int _hdl_sprintf_bindings (char *buffer, struct HDL_Interface *interface, struct HDL_Element *element) {
-    if(element->content == NULL)
+// Returns an array item, the string itself for HDL_TYPE_STRING. NULL if out of range
+const void *_hdl_arrayItem (const struct HDL_Array *array, uint16_t index) {
+    if(array == NULL || index >= array->count || array->type >= HDL_TYPE_COUNT)
+        return NULL;
+    if(array->type == HDL_TYPE_STRING)
+        return ((const char * const*)array->items)[index];
+    return (const uint8_t*)array->items + index * TYPE_SIZES[array->type];
+}
+
+int _hdl_sprintf_bindings (char *buffer, int size, struct HDL_Interface *interface, struct HDL_ElementExt *ext) {
+    if(ext->content == NULL)
         return 1;
     
-    char savedChar = 0;
-    int len = strlen(element->content);
+    // Format specifier being formatted, the content itself is not modified so it can be in flash
+    char spec[16];
+    int len = strlen(ext->content);
 
     char *start_w = buffer;
-    char *start_r = element->content;
+    // Last writable character, the buffer is always null terminated
+    char *end_w = buffer + size - 1;
+    const char *start_r = ext->content;
     uint8_t state = 0;
     uint8_t bind_index = 0;
     for(int i = 0; i < len; i++) {
         if(state == 0) {
-            if(element->content[i] == '%') {
-                if(i >= 1 && element->content[i - 1] == '\\') {
+            if(ext->content[i] == '%') {
+                if(i >= 1 && ext->content[i - 1] == '\\') {
                     // Escaped format, ignore
-                    (*(start_w - 1)) = element->content[i];
+                    (*(start_w - 1)) = ext->content[i];
                     continue;
                 }
-                start_r = &element->content[i];
+                start_r = &ext->content[i];
                 state = 1;
             }
-            else {
-                (*start_w) = element->content[i];
+            else if(start_w < end_w) {
+                (*start_w) = ext->content[i];
                 start_w++;
             }
         }
         else if(state == 1) {
-            if(_hdl_is_format_spec(element->content[i])) {
-                // Format specifier, set next character to terminating character
-                // Save old character
-                savedChar = element->content[i + 1];
-                element->content[i + 1] = 0;
+            if(_hdl_is_format_spec(ext->content[i])) {
+                // Format specifier, copied with its flags and width. Overlong ones are cut before the conversion
+                int specLen = &ext->content[i] - start_r;
+                if(specLen > (int)sizeof(spec) - 2)
+                    specLen = sizeof(spec) - 2;
+                memcpy(spec, start_r, specLen);
+                spec[specLen] = ext->content[i];
+                spec[specLen + 1] = 0;
                 int lenw = 0;
 
-                struct HDL_Binding *binding = HDL_GetBinding(interface, element->bindings[bind_index]);
+                struct HDL_Binding *binding = HDL_GetBinding(interface, ext->bindings[bind_index]);
                 int intval = 0;
                 float floatval = 0;
                 char *strval = NULL;
-                switch (binding->type) {
+                enum HDL_Type type = binding->type;
+                const void *data = binding->data;
+                if(type == HDL_TYPE_ARRAY) {
+                    // Item of the list row being drawn
+                    type = ((const struct HDL_Array*)data)->type;
+                    data = _hdl_arrayItem((const struct HDL_Array*)data, interface->_listRow);
+                    if(data == NULL)
+                        type = HDL_TYPE_NULL;
+                }
+                switch (type) {
                     case HDL_TYPE_FLOAT:
-                        intval = *(float*)binding->data;
-                        floatval = *(float*)binding->data;
+                        intval = *(float*)data;
+                        floatval = *(float*)data;
                         break;
                     case HDL_TYPE_BOOL:
                     case HDL_TYPE_I8:
-                        intval = *(int8_t*)binding->data;
-                        floatval = *(int8_t*)binding->data;
+                        intval = *(int8_t*)data;
+                        floatval = *(int8_t*)data;
                         break;
                     case HDL_TYPE_IMG:
                     case HDL_TYPE_I16:
-                        intval = *(int16_t*)binding->data;
-                        floatval = *(int16_t*)binding->data;
+                        intval = *(int16_t*)data;
+                        floatval = *(int16_t*)data;
                         break;
                     case HDL_TYPE_I32:
-                        intval = *(int32_t*)binding->data;
-                        floatval = *(int32_t*)binding->data;
+                        intval = *(int32_t*)data;
+                        floatval = *(int32_t*)data;
                         break;
                     case HDL_TYPE_STRING:
-                        strval = (char*)binding->data;
+                        strval = (char*)data;
                         break;
                     case HDL_TYPE_NULL:
                     case HDL_TYPE_BIND:
@@ -185,7 +328,7 @@ int _hdl_sprintf_bindings (char *buffer, struct HDL_Interface *interface, struct
                 }
 
 
-                switch(element->content[i]) {
+                switch(ext->content[i]) {
                     case 'd':
                     case 'i':
                     case 'u':
@@ -194,7 +337,7 @@ int _hdl_sprintf_bindings (char *buffer, struct HDL_Interface *interface, struct
                     case 'X':
                     {
                         // Format INTEGER
-                        lenw = sprintf(start_w, start_r, intval);
+                        lenw = snprintf(start_w, end_w - start_w + 1, spec, intval);
                         break;
                     }
                     case 'f':
@@ -203,30 +346,34 @@ int _hdl_sprintf_bindings (char *buffer, struct HDL_Interface *interface, struct
                     case 'g':
                     {
                         // Format FLOAT
-                        lenw = sprintf(start_w, start_r, floatval);
+                        lenw = snprintf(start_w, end_w - start_w + 1, spec, floatval);
                         break;
                     }
                     case 'p':
                     {
                         // Format POINTER
-                        lenw = sprintf(start_w, start_r, intval);
+                        lenw = snprintf(start_w, end_w - start_w + 1, spec, intval);
                         break;
                     }
                     case 'c':
                     {
                         // Format CHARACTER
-                        lenw = sprintf(start_w, start_r, strval[0]);
+                        lenw = snprintf(start_w, end_w - start_w + 1, spec, strval[0]);
                         break;
                     }
                     case 's':
                     {
                         // Format STRING
-                        lenw = sprintf(start_w, start_r, strval);
+                        lenw = snprintf(start_w, end_w - start_w + 1, spec, strval);
                         break;
                     }
                 }
-                element->content[i + 1] = savedChar;
-                start_r = element->content + i + 1;
+                start_r = ext->content + i + 1;
+                // snprintf returns the untruncated length
+                if(lenw > end_w - start_w)
+                    lenw = end_w - start_w;
+                else if(lenw < 0)
+                    lenw = 0;
                 start_w = start_w + lenw;
 
                 bind_index++;
@@ -239,937 +386,5095 @@ int _hdl_sprintf_bindings (char *buffer, struct HDL_Interface *interface, struct
 }
 
 int _hdl_handleBoundAttrs (struct HDL_Interface *interface, struct HDL_Element *element) {
-    for(int i = 0; i < element->boundAttrCount; i++) {
-        struct HDL_AttrBind *battr = &element->bound_attrs[i];
+    struct HDL_ElementExt *ext = _hdl_getExt(interface, element);
+    if(ext == NULL || ext->attrs == NULL)
+        return 0;
+    struct HDL_Attrs *attrs = ext->attrs;
+
+    uint16_t image = attrs->image;
+    uint8_t sprite = attrs->sprite;
+    uint16_t widget = attrs->widget;
+    uint16_t font = attrs->font;
+
+    for(int i = 0; i < ext->boundAttrCount; i++) {
+        struct HDL_AttrBind *battr = &interface->attrBinds[ext->boundAttrs + i];
         struct HDL_Binding *binding = HDL_GetBinding(interface, battr->bind.value);
         switch(battr->key) {
             case HDL_ATTR_X:
-                element->attrs.x = *(int16_t*)binding->data;
+                element->x = *(int16_t*)binding->data;
                 break;
             case HDL_ATTR_Y:
-                element->attrs.y = *(int16_t*)binding->data;
+                element->y = *(int16_t*)binding->data;
                 break;
             case HDL_ATTR_WIDTH:
-                element->attrs.width = *(uint16_t*)binding->data;
+                element->width = *(uint16_t*)binding->data;
                 break;
             case HDL_ATTR_HEIGHT:
-                element->attrs.height = *(uint16_t*)binding->data;
+                element->height = *(uint16_t*)binding->data;
                 break;
             case HDL_ATTR_FLEX:
-                element->attrs.flex = *(uint8_t*)binding->data;
+                attrs->flex = *(uint8_t*)binding->data;
                 break;
             case HDL_ATTR_FLEX_DIR:
-                element->attrs.flexDir = *(uint8_t*)binding->data;
+                attrs->flexDir = *(uint8_t*)binding->data;
                 break;
             case HDL_ATTR_BIND:
                 // Should not be bound
                 return 1;
                 break;
             case HDL_ATTR_IMG:
-                element->attrs.image = *(uint16_t*)binding->data;
+                attrs->image = *(uint16_t*)binding->data;
+                break;
+            case HDL_ATTR_FONT:
+                attrs->font = *(uint16_t*)binding->data;
+                break;
+            case HDL_ATTR_SCROLL:
+                attrs->scroll = *(uint16_t*)binding->data;
                 break;
             case HDL_ATTR_PADDING:
                 if(battr->count == 1) {
-                    element->attrs.padding_x = *(int16_t*)binding->data;
-                    element->attrs.padding_y = *(int16_t*)binding->data;
+                    attrs->padding_x = *(int16_t*)binding->data;
+                    attrs->padding_y = *(int16_t*)binding->data;
                 }
                 else {
-                    element->attrs.padding_x = *(int16_t*)HDL_GetBinding(interface, battr->bind.values[0])->data;
-                    element->attrs.padding_y = *(int16_t*)HDL_GetBinding(interface, battr->bind.values[1])->data;
+                    attrs->padding_x = *(int16_t*)HDL_GetBinding(interface, battr->bind.values[0])->data;
+                    attrs->padding_y = *(int16_t*)HDL_GetBinding(interface, battr->bind.values[1])->data;
                 }
                 break;
             case HDL_ATTR_ALIGN:
-                element->attrs.align = *(uint8_t*)binding->data;
+                attrs->align = *(uint8_t*)binding->data;
                 break;
             case HDL_ATTR_SIZE:
-                element->attrs.size = *(uint8_t*)binding->data;
+                attrs->size = *(uint8_t*)binding->data;
                 break;
             case HDL_ATTR_DISABLED:
-                element->attrs.disabled = *(uint8_t*)binding->data;
+                element->disabled = *(uint8_t*)binding->data;
                 break;
             case HDL_ATTR_VALUE:
-                element->attrs.value = *(uint8_t*)binding->data;
+                attrs->value = *(uint8_t*)binding->data;
                 break;
             case HDL_ATTR_SPRITE:
-                element->attrs.sprite = *(uint8_t*)binding->data;
+                attrs->sprite = *(uint8_t*)binding->data;
+                break;
+            case HDL_ATTR_FILL:
+                attrs->fill = *(uint8_t*)binding->data;
+                break;
+            case HDL_ATTR_COLOR:
+                attrs->color = *(uint8_t*)binding->data;
+                break;
+            case HDL_ATTR_BACKGROUND:
+                attrs->background = *(uint8_t*)binding->data;
                 break;
         }
     }
+
+    // Bound references changed
+    if(image != attrs->image || sprite != attrs->sprite || widget != attrs->widget || font != attrs->font) {
+        _hdl_resolveElement(interface, element);
+    }
     return 0;
 }
 
-int _hdl_handleElement (struct HDL_Interface *interface, struct HDL_Element *element) {
-    int flags = element->flags;
-
-    // Update element bound attributes
-    _hdl_handleBoundAttrs(interface, element);
-
-    if(element->attrs.disabled)
-        return flags;
-
-    uint16_t totalFlex = 0;
-
-    // Calculate children flex
-    #ifdef HDL_CONF_STATIC_CHILDREN_COUNT
-    for(int i = 0; i < HDL_CONF_STATIC_CHILDREN_COUNT; i++) {
-#else
-    for(int i = 0; i < element->child_count; i++) {
-#endif
-        if(element->children[i] == 0xFF)
-            continue;
+// Passes batched spans to the driver. Called before any other drawing call to keep the drawing order
+void _hdl_flushSpans (struct HDL_Interface *interface) {
+    if(interface->_spanCount > 0) {
+        interface->f_spans(interface->_spans, interface->_spanCount);
+        interface->_spanCount = 0;
+    }
+}
 
-        if(element->tag == HDL_TAG_SWITCH) {
-            // Set disabled value according to element's value
-            if(element->attrs.value == i) {
-                interface->elements[element->children[i]].attrs.disabled = 0;
-            }
-            else {
-                interface->elements[element->children[i]].attrs.disabled = 1;
-            }
+// Draws a horizontal span of pixels
+void _hdl_span (struct HDL_Interface *interface, int16_t x, int16_t y, int16_t len) {
+    if(interface->_clipping) {
+        struct HDL_Bounds *clip = &interface->_clip;
+        if(y < clip->y || y >= clip->y + clip->h)
+            return;
+        if(x < clip->x) {
+            len -= clip->x - x;
+            x = clip->x;
         }
+        if(x + len > clip->x + clip->w)
+            len = clip->x + clip->w - x;
+    }
+    if(len <= 0)
+        return;
 
-        struct HDL_Element *child = &interface->elements[element->children[i]];
-        if(child->attrs.disabled)
-            continue;
+    if(interface->f_spans != NULL) {
+        if(interface->_spans == NULL && (interface->_spans = HMALLOC(sizeof(struct HDL_Span) * HDL_CONF_SPAN_BATCH)) == NULL) {
+            // Not batched
+            struct HDL_Span span = { x, y, len };
+            interface->f_spans(&span, 1);
+            return;
+        }
+        if(interface->_spanCount >= HDL_CONF_SPAN_BATCH)
+            _hdl_flushSpans(interface);
 
-        totalFlex += child->attrs.flex;
+        struct HDL_Span *span = &interface->_spans[interface->_spanCount++];
+        span->x = x;
+        span->y = y;
+        span->len = len;
+    }
+    else if(interface->f_hline != NULL) {
+        interface->f_hline(x, y, len);
+    }
+    else if(interface->f_pixel != NULL) {
+        for(int i = 0; i < len; i++) {
+            interface->f_pixel(x + i, y);
+        }
     }
+}
 
-    int16_t curFlexX = element->attrs.x;
-    int16_t curFlexY = element->attrs.y;
-    
-    // Loop through children
-#ifdef HDL_CONF_STATIC_CHILDREN_COUNT
-    for(int i = 0; i < HDL_CONF_STATIC_CHILDREN_COUNT; i++) {
-#else
-    for(int i = 0; i < element->child_count; i++) {
-#endif
-        if(element->children[i] == 0xFF)
-            continue;
+// Sets the drawing color, the driver is called only if the color changes
+void _hdl_setColor (struct HDL_Interface *interface, uint8_t r, uint8_t g, uint8_t b) {
+    uint32_t color = ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    if(color == interface->_color || interface->f_setColor == NULL)
+        return;
 
-        struct HDL_Element *child = &interface->elements[element->children[i]];
+    _hdl_flushSpans(interface);
+    interface->f_setColor(r, g, b);
+    interface->_color = color;
+}
 
-        if(child->attrs.disabled)
-            continue;
+// Sets the drawing color from the palette. Without a palette the foreground is restored
+// once a palette bitmap has changed the driver color
+void _hdl_setPaletteColor (struct HDL_Interface *interface, uint8_t index) {
+    if(interface->palette == NULL || index >= interface->paletteSize) {
+        uint32_t fg = interface->foreground;
+        if(interface->_color != HDL_COLOR_UNKNOWN)
+            _hdl_setColor(interface, fg >> 16, (fg >> 8) & 0xFF, fg & 0xFF);
+        return;
+    }
 
-        child->attrs.x = curFlexX;
-        child->attrs.y = curFlexY;
+    const uint8_t *rgb = &interface->palette[index * 3];
+    _hdl_setColor(interface, rgb[0], rgb[1], rgb[2]);
+}
 
-        if(element->attrs.flexDir == HDL_FLEX_COLUMN) {
-            int16_t addF = (uint16_t)ceilf((float)child->attrs.flex / (float)totalFlex * element->attrs.width);
-            // Set child width
-            child->attrs.width = addF;
-            // Height from parent
-            child->attrs.height = element->attrs.height;
+// Fills a rectangle
+void _hdl_rect (struct HDL_Interface *interface, int16_t x, int16_t y, int16_t w, int16_t h) {
+    if(interface->_clipping) {
+        struct HDL_Bounds *clip = &interface->_clip;
+        int16_t x2 = x + w;
+        int16_t y2 = y + h;
+        if(x < clip->x)
+            x = clip->x;
+        if(y < clip->y)
+            y = clip->y;
+        if(x2 > clip->x + clip->w)
+            x2 = clip->x + clip->w;
+        if(y2 > clip->y + clip->h)
+            y2 = clip->y + clip->h;
+        w = x2 - x;
+        h = y2 - y;
+    }
+    if(w <= 0 || h <= 0)
+        return;
 
-            curFlexX += addF;
-        }
-        else if(element->attrs.flexDir == HDL_FLEX_ROW) {
-            int16_t addF = (uint16_t)ceilf((float)child->attrs.flex / (float)totalFlex * element->attrs.height);
-            // Set child height
-            child->attrs.height = addF;
-            // Width from parent
-            child->attrs.width = element->attrs.width;
+    if(interface->f_fillRect != NULL) {
+        _hdl_flushSpans(interface);
+        interface->f_fillRect(x, y, w, h);
+        return;
+    }
 
-            curFlexY += addF;
+    if(interface->f_spans == NULL && interface->f_vline != NULL && w < h) {
+        // Narrow rectangle, one line per column
+        uint8_t strokeWidth_old = interface->strokeWidth;
+        interface->strokeWidth = 1;
+        for(int16_t col = 0; col < w; col++) {
+            interface->f_vline(x + col, y, h);
         }
+        interface->strokeWidth = strokeWidth_old;
+        return;
+    }
 
+    for(int16_t row = 0; row < h; row++) {
+        _hdl_span(interface, x, y + row, w);
+    }
+}
 
-        flags |= _hdl_handleElement(interface, child);
+// Integer square root
+uint32_t _hdl_isqrt (uint32_t value) {
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
 
+    while(bit > value) {
+        bit >>= 2;
     }
+    while(bit != 0) {
+        if(value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
 
-    // DEBUG lines
-    /*
-    interface->f_hline(element->x, element->y, element->width);
-    interface->f_hline(element->x, element->y + element->height, element->width);
-
-    interface->f_vline(element->x, element->y, element->height);
-    interface->f_vline(element->x + element->width, element->y, element->height);
-    */
+// Horizontal extent of a circle of radius r, dy rows from its center. Midpoint criterion x² + dy² <= r² + r
+int16_t _hdl_circleExtent (int16_t r, int16_t dy) {
+    int32_t value = (int32_t)r * r + r - (int32_t)dy * dy;
+    return value > 0 ? _hdl_isqrt(value) : 0;
+}
 
-    int8_t pad_x = 0;
-    int8_t pad_y = 0;
+// Distance from the corner circle center of a row in a rounded box, 0 if the row is not in a corner
+int16_t _hdl_cornerOffset (int16_t row, int16_t h, int16_t r) {
+    if(row < r)
+        return r - row;
+    if(row >= h - r)
+        return row - (h - 1 - r);
+    return 0;
+}
 
-    if(element->parent != NULL) {
-        pad_x = element->parent->attrs.padding_x;
-        pad_y = element->parent->attrs.padding_y;
-    }
-    if(element->attrs.border > 0) {
+/**
+ * @brief Draws a rounded rectangle as horizontal spans, with any stroke width
+ * 
+ * @param interface 
+ * @param x Left
+ * @param y Top
+ * @param w Width
+ * @param h Height
+ * @param r Corner radius
+ * @param stroke Stroke width
+ * @param fill Fill the rectangle instead of stroking it
+ */
+void _hdl_roundRect (struct HDL_Interface *interface, int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, int16_t stroke, uint8_t fill) {
+    if(w <= 0 || h <= 0)
+        return;
 
-        uint8_t diameter = element->attrs.radius * 2;
+    if(r > w / 2)
+        r = w / 2;
+    if(r > h / 2)
+        r = h / 2;
+    if(stroke < 1)
+        stroke = 1;
+    if(stroke * 2 >= w || stroke * 2 >= h)
+        fill = 1;
 
-        int16_t x1 = element->attrs.x + pad_x/2;
-        int16_t x2 = element->attrs.x + element->attrs.width - pad_x/2;
-        int16_t y1 = element->attrs.y + pad_y/2;
-        int16_t y2 = element->attrs.y + element->attrs.height - pad_y/2;
+    // Inner rounded box
+    int16_t ri = r > stroke ? r - stroke : 0;
+    int16_t ih = h - stroke * 2;
 
-        if(x2 == interface->width)
-            x2 = interface->width - 1;
+    // Rows where both edges are straight
+    int16_t straight = r > stroke ? r : stroke;
+    uint8_t edges = !fill && h - straight * 2 > 0;
 
-        if(y2 == interface->height)
-            y2 = interface->height - 1;
+    for(int16_t row = 0; row < h; row++) {
+        int16_t dy = _hdl_cornerOffset(row, h, r);
+        int16_t inset = dy ? r - _hdl_circleExtent(r, dy) : 0;
 
+        int16_t left = x + inset;
+        int16_t right = x + w - 1 - inset;
 
-        // Set strokeWidth
-        uint8_t strokeWidth_old = interface->strokeWidth;
-        interface->strokeWidth = element->attrs.border;
-
-        // Border
-        // Left
-        interface->f_vline(
-            x1, 
-            y1 + element->attrs.radius,
-            element->attrs.height - pad_y - diameter + 1
-        );
-        // Right
-        interface->f_vline(
-            x2, 
-            y1 + element->attrs.radius,
-            element->attrs.height - pad_y - diameter + 1
-        );
-        // Top
-        interface->f_hline(
-            x1 + element->attrs.radius,
-            y1,
-            element->attrs.width - pad_x - diameter + 1
-        );
-        // Bottom
-        interface->f_hline(
-            x1 + element->attrs.radius,
-            y2,
-            element->attrs.width - pad_x - diameter + 1
-        );
-        // Corners
-        if(element->attrs.radius) {
-            if(interface->f_arc) {
-                interface->f_arc(x1 + element->attrs.radius + 1, y1 + element->attrs.radius + 1, element->attrs.radius, 180, 270);
-                interface->f_arc(x2 - element->attrs.radius + 1, y1 + element->attrs.radius + 1, element->attrs.radius, 270, 360);
-                interface->f_arc(x2 - element->attrs.radius + 1, y2 - element->attrs.radius + 1, element->attrs.radius, 0, 90);
-                interface->f_arc(x1 + element->attrs.radius + 1, y2 - element->attrs.radius + 1, element->attrs.radius, 90, 180);
+        if(fill || row < stroke || row >= h - stroke) {
+            _hdl_span(interface, left, y + row, right - left + 1);
+            continue;
+        }
 
-            }
+        if(edges && row >= straight && row < h - straight) {
+            // Drawn as rectangles below
+            continue;
         }
-        interface->strokeWidth = strokeWidth_old;
+
+        int16_t idy = _hdl_cornerOffset(row - stroke, ih, ri);
+        int16_t iinset = stroke + (idy ? ri - _hdl_circleExtent(ri, idy) : 0);
+
+        _hdl_span(interface, left, y + row, x + iinset - left);
+        _hdl_span(interface, x + w - iinset, y + row, right - (x + w - iinset) + 1);
     }
 
-    // Set alignment point
-    int16_t align_x = 0;
-    int16_t align_y = 0;
+    if(edges) {
+        // Straight edges
+        _hdl_rect(interface, x, y + straight, stroke, h - straight * 2);
+        _hdl_rect(interface, x + w - stroke, y + straight, stroke, h - straight * 2);
+    }
+}
 
-    uint8_t hzAlign = element->attrs.align >> 4;
-    uint8_t vtAlign = element->attrs.align & 0xF;
+// Sequential reader over raw or PackBits compressed bitmap data
+struct _hdl_BitmapReader {
+    const uint8_t *src;
+    const uint8_t *end;
+    // PackBits compressed
+    uint8_t rle;
+    // Bytes left in the current run
+    uint8_t count;
+    // Current run is literal bytes
+    uint8_t literal;
+    // Repeated byte
+    uint8_t value;
+    // Returned past the end of data
+    uint8_t fill;
+};
 
-    uint16_t contW = 0;
-    uint16_t contH = 0;
+uint8_t _hdl_readBitmapByte (struct _hdl_BitmapReader *reader) {
+    if(!reader->rle) {
+        return reader->src < reader->end ? *reader->src++ : reader->fill;
+    }
 
-    char content_buffer[256];
-    memset(content_buffer, 0, sizeof(content_buffer));
+    while(reader->count == 0) {
+        if(reader->src >= reader->end)
+            return reader->fill;
 
-    if(element->content != NULL) {
-        if(element->bind_count > 0) {
-            _hdl_sprintf_bindings(content_buffer, interface, element);
+        int8_t header = (int8_t)*reader->src++;
+        if(header >= 0) {
+            // header + 1 literal bytes
+            reader->count = header + 1;
+            reader->literal = 1;
         }
-        else {
-            strcpy(content_buffer, element->content);
+        else if(header != -128) {
+            // Next byte repeated 1 - header times
+            if(reader->src >= reader->end)
+                return reader->fill;
+            reader->count = 1 - header;
+            reader->literal = 0;
+            reader->value = *reader->src++;
         }
-        // Get string size
-        _hdl_str_size(content_buffer, &contW, &contH);
-        contW *= (interface->textWidth + 1) * element->attrs.size;
-        contH *= (interface->textHeight + 1) * element->attrs.size;
     }
-    if(element->attrs.image != 0xFFFF) {
-        
-        struct HDL_Bitmap *bmp = _hdl_getBitmap(interface, element->attrs.image);
 
-        if(bmp != NULL) {
-            // Get image size
-            uint16_t imgWidth = bmp->sprite_width * element->attrs.size;
-            uint16_t imgHeight = bmp->sprite_height * element->attrs.size;
+    reader->count--;
+    if(reader->literal) {
+        return reader->src < reader->end ? *reader->src++ : reader->fill;
+    }
+    return reader->value;
+}
 
-            if(contW < imgWidth) {
-                contW = imgWidth;
-            }
-            if(contH < imgHeight) {
-                contH = imgHeight;
-            }
-        }
+// Skips bytes of bitmap data
+void _hdl_skipBitmapBytes (struct _hdl_BitmapReader *reader, uint32_t count) {
+    if(!reader->rle) {
+        reader->src = (uint32_t)(reader->end - reader->src) > count ? reader->src + count : reader->end;
+        return;
+    }
+    while(count--) {
+        _hdl_readBitmapByte(reader);
     }
+}
 
-    int8_t pad_dir_x = 1;
-    int8_t pad_dir_y = 1;
+// Draws a run of same colored bitmap pixels, scaled by size
+void _hdl_bitmapRun (struct HDL_Interface *interface, const uint8_t *palette, uint8_t index, int16_t x, int16_t y, int16_t len, uint8_t size) {
+    if(palette == NULL) {
+        // Mono, 0 bits are drawn
+        if(index)
+            return;
+    }
+    else {
+        // Palette, index 0 is transparent
+        if(index == 0)
+            return;
+        _hdl_setColor(interface, palette[index * 3], palette[index * 3 + 1], palette[index * 3 + 2]);
+    }
+    for(int sy = 0; sy < size; sy++) {
+        _hdl_span(interface, x, y + sy, len * size);
+    }
+}
 
-    // Y alignment, 0/default is middle
-    switch(vtAlign) {
-        case HDL_ALIGN_Y_TOP:
-        {
-            // Top
-            align_y = pad_y/2;
-            break;
-        }
-        case HDL_ALIGN_Y_BOTTOM:
-        {
-            // Bottom
-            align_y = element->attrs.height - contH - pad_y/2;
-            pad_dir_y = -1;
-            break;
-        }
-        default:
-        {
-            // Middle
-            align_y = (element->attrs.height / 2) - (contH / 2);
+/**
+ * @brief Draws a bitmap sprite. Rows are decoded one at a time straight into spans,
+ * compressed bitmaps are never inflated in memory
+ * 
+ * @param interface 
+ * @param bmp Bitmap
+ * @param start_x Sprite position in the bitmap
+ * @param start_y Sprite position in the bitmap
+ * @param x Screen position
+ * @param y Screen position
+ * @param size Scale
+ */
+void _hdl_drawBitmap (struct HDL_Interface *interface, struct HDL_Bitmap *bmp, uint16_t start_x, uint16_t start_y, int16_t x, int16_t y, uint8_t size) {
+    uint8_t *data = _hdl_getBitmapData(interface, bmp);
+    if(data == NULL || bmp->width == 0)
+        return;
+
+    uint8_t bpp = 1;
+    const uint8_t *palette = NULL;
+    uint16_t paletteSize = 0;
+
+    switch(bmp->colorMode & 0x0F) {
+        case HDL_BITMAP_PAL2:
+            bpp = 2;
+            paletteSize = 4 * 3;
             break;
-        }
-    }
-    // X alignment, 0/default is center
-    switch(hzAlign) {
-        case HDL_ALIGN_X_LEFT:
-        {
-            align_x = pad_x/2;
+        case HDL_BITMAP_PAL4:
+            bpp = 4;
+            paletteSize = 16 * 3;
             break;
-        }
-        case HDL_ALIGN_X_RIGHT:
-        {
-            align_x = element->attrs.width - contW - pad_x/2;
-            pad_dir_x = -1;
+        case HDL_BITMAP_MONO:
             break;
-        }
         default:
-        {
-            // Center
-            align_x = (element->attrs.width / 2) - (contW / 2);
-            break;
-        }
+            // Unknown format
+            return;
     }
 
-    int16_t aligned_x = align_x + element->attrs.x + element->attrs.padding_x * pad_dir_x;
-    int16_t aligned_y = align_y + element->attrs.y + element->attrs.padding_y * pad_dir_y;
-
+    if(bmp->size < paletteSize)
+        return;
+    if(paletteSize > 0)
+        palette = data;
+
+    struct _hdl_BitmapReader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.src = data + paletteSize;
+    reader.end = data + bmp->size;
+    reader.rle = (bmp->colorMode & HDL_BITMAP_RLE) != 0;
+    reader.fill = palette == NULL ? 0xFF : 0x00;
+
+    uint16_t rowBytes = ((uint32_t)bmp->width * bpp + 7) / 8;
+    uint16_t end_x = start_x + bmp->sprite_width;
+    uint8_t mask = (1 << bpp) - 1;
+
+    // Rows above the sprite
+    _hdl_skipBitmapBytes(&reader, (uint32_t)start_y * rowBytes);
+
+    for(int row = 0; row < bmp->sprite_height; row++) {
+        int16_t py = y + row * size;
+        int16_t runStart = 0;
+        int16_t runLen = 0;
+        uint8_t runIndex = 0;
+        uint16_t col = 0;
+
+        for(int b = 0; b < rowBytes; b++) {
+            uint8_t byte = _hdl_readBitmapByte(&reader);
+
+            for(int shift = 8 - bpp; shift >= 0; shift -= bpp, col++) {
+                if(col < start_x || col >= end_x)
+                    continue;
 
-    if(interface->f_text != NULL && element->content != NULL) {
-        if(element->bind_count > 0) {
-            interface->f_text(aligned_x, aligned_y, content_buffer, element->attrs.size);
-        }
-        else {
-            interface->f_text(aligned_x, aligned_y, content_buffer, element->attrs.size);
-        }
-    }
-    if(interface->f_pixel != NULL && element->attrs.image != 0xFFFF) {
-            
-        struct HDL_Bitmap *bmp = _hdl_getBitmap(interface, element->attrs.image);
-        if(bmp != NULL) {
-            int pad_width = (bmp->width + 7) / 8;
-            uint16_t sprite_xp = bmp->sprite_width * element->attrs.sprite;
-            uint16_t start_x = sprite_xp % bmp->width;
-            uint16_t start_y = (sprite_xp / bmp->width) * bmp->sprite_height;
-
-            for(int y = 0; y < bmp->sprite_height; y++) {
-                for(int x = 0; x < bmp->sprite_width; x++) {
-                    uint8_t bmpData = bmp->data[(y + start_y) * pad_width + (x + start_x) / 8] & (1 << (7 - ((x + start_x) % 8)));
-                    if(!bmpData) {
-                        for(int sx = 0; sx < element->attrs.size; sx++) {
-                            for(int sy = 0; sy < element->attrs.size; sy++) {
-                                interface->f_pixel(aligned_x + (x * element->attrs.size) + sx, aligned_y + (y * element->attrs.size) + sy);
-                            }
-                        }
-                    }
+                uint8_t index = (byte >> shift) & mask;
+                if(runLen > 0 && index == runIndex) {
+                    runLen++;
+                    continue;
                 }
+                if(runLen > 0)
+                    _hdl_bitmapRun(interface, palette, runIndex, x + runStart * size, py, runLen, size);
+
+                runStart = col - start_x;
+                runIndex = index;
+                runLen = 1;
             }
         }
+        if(runLen > 0)
+            _hdl_bitmapRun(interface, palette, runIndex, x + runStart * size, py, runLen, size);
     }
-    if(element->attrs.widget != 0xFFFF) {
-        for(int i = 0; i < HDL_CONF_MAX_WIDGETS; i++) {
-            if(interface->widgets[i].id == element->attrs.widget) {
-                interface->widgets[i].widget(interface, (const struct HDL_Element*)element);
-                break;
-            }
-        }
-    }
-
-    return flags;
 }
 
-// Initializes an element to default values
-void HDL_InitElement (struct HDL_Element *element) {
-    if(element == NULL)
-        return;
+// Render traversal frame
+struct _hdl_RenderFrame {
+    struct HDL_Element *element;
+    // Next child
+    uint16_t next;
+    // Flex total of enabled children
+    uint16_t totalFlex;
+    // Flex cursor
+    int16_t curFlexX;
+    int16_t curFlexY;
+    // Foreground color index, inherited by children
+    uint8_t color;
+    // Next row of a list, its rows are drawn on the same work stack
+    uint16_t row;
+    // Array item of the enclosing row, restored after the rows
+    uint16_t savedRow;
+    // Template of a row is being drawn
+    uint8_t inRow;
+};
 
-    memset(element, 0, sizeof(struct HDL_Element));
-    element->attrs.flex = 1;
-    element->attrs.flexDir = HDL_FLEX_ROW;
-    element->attrs.image = 0xFFFF;
-    element->attrs.size = 1;
-    
-    // Set children to 0xFF
-#ifdef HDL_CONF_STATIC_CHILDREN_COUNT
-    memset(element->children, 0xFF, HDL_CONF_STATIC_CHILDREN_COUNT);
-#else
-    // TODO:
-#endif
+void _hdl_showPage (struct HDL_Interface *interface, struct HDL_Element *element);
 
-}
+// Prepares the children of the frame's element for layout by _hdl_nextChild
+void _hdl_layoutChildren (struct HDL_Interface *interface, struct _hdl_RenderFrame *frame) {
+    struct HDL_Element *element = frame->element;
+    const struct HDL_ElementDesc *desc = _hdl_desc(interface, element);
+    const struct HDL_Attrs *attrs = _hdl_attrs(interface, element);
 
-int HDL_SetBinding (struct HDL_Interface *interface, const char *key, uint16_t id, void *binding, enum HDL_Type type) {
+    frame->next = desc->first_child;
+    frame->totalFlex = 0;
+    frame->curFlexX = element->x;
+    frame->curFlexY = element->y;
 
-    for(int i = 0; i < HDL_CONF_MAX_BINDINGS; i++) {
-        if(interface->bindings[i].id == 0xFFFF) {
-            interface->bindings[i].id = id;
-            interface->bindings[i].data = binding;
-            interface->bindings[i].type = type;
+    // Static children are already laid out
+    if(desc->first_child == HDL_NO_ELEMENT || (interface->elements[desc->first_child].flags & HDL_FLAG_STATIC))
+        return;
 
-            #ifdef HDL_CONF_BIND_COPIES
-            interface->_bindings_cpy[i].id = id;
-            interface->_bindings_cpy[i].data = HMALLOC(TYPE_SIZES[type]);
-            memcpy(interface->_bindings_cpy[i].data, binding, TYPE_SIZES[type]);
-            interface->_bindings_cpy[i].type = type;
-            #endif
+    uint16_t totalFlex = 0;
 
-            return 0;
+    // Calculate children flex
+    uint16_t i = 0;
+    for(uint16_t c = desc->first_child; c != HDL_NO_ELEMENT; c = interface->elementDesc[c].next_sibling, i++) {
+        struct HDL_Element *child = &interface->elements[c];
+
+        if(desc->tag == HDL_TAG_SWITCH) {
+            // Set disabled value according to element's value
+            child->disabled = attrs->value != i;
+            if(!child->disabled && (child->flags & HDL_FLAG_PAGE))
+                _hdl_showPage(interface, child);
         }
-    }
 
-    return 1;
-}
+        if(child->disabled)
+            continue;
 
-struct HDL_Binding *HDL_GetBinding (struct HDL_Interface *interface, uint16_t id) {
+        totalFlex += _hdl_attrs(interface, child)->flex;
+    }
 
-    for(int i = 0; i < HDL_CONF_MAX_BINDINGS; i++) {
-        if(interface->bindings[i].id == id) {
-            return &interface->bindings[i];
-        }
+    frame->totalFlex = totalFlex;
+
+    if(desc->tag == HDL_TAG_SCROLL) {
+        // Content is shifted by the offset
+        if(attrs->flexDir == HDL_FLEX_COLUMN)
+            frame->curFlexX -= attrs->scroll;
+        else
+            frame->curFlexY -= attrs->scroll;
     }
-    return NULL;
 }
 
-// Parses a single element
-int _hdl_buildElement (struct HDL_Interface *interface, struct HDL_Element *parent, int *elementIndex, uint8_t *data, int *pc) {
+// Updates element and prepares its children for layout. Returns 0 if the element is disabled
+int _hdl_enterElement (struct HDL_Interface *interface, struct _hdl_RenderFrame *frame) {
+    struct HDL_Element *element = frame->element;
 
-    struct HDL_Element *el = &interface->elements[(*elementIndex)++];
-    // Initialize element (zero and set defaults)
-    HDL_InitElement(el);
-    
-    // Tag is the first byte
-    el->tag = (uint8_t)data[(*pc)];
-    (*pc)++;
+    // Update element bound attributes
+    _hdl_handleBoundAttrs(interface, element);
+    const struct HDL_Attrs *attrs = _hdl_attrs(interface, element);
 
-    // Set parent
-    el->parent = parent;
-    
-    // Set content
-    if(data[*pc] != 0) {
-        int contentLength = strlen((const char*)&data[(*pc)]);
-        el->content = HMALLOC(contentLength + 1);
-        memcpy(el->content, &data[(*pc)], contentLength);
-        el->content[contentLength] = 0;
-
-        (*pc) += contentLength + 1;
+    if(element->disabled) {
+        if(element->flags & HDL_FLAG_VISIBLE)
+            _hdl_hideSubtree(interface, element);
+        return 0;
     }
-    else {
-        el->content = NULL;
-        (*pc)++;
+
+    // Inherits the parent color by default
+    if(attrs->color != HDL_COLOR_NONE)
+        frame->color = attrs->color;
+
+    if(_hdl_desc(interface, element)->tag == HDL_TAG_LIST) {
+        // Rows are laid out from the template when the list is drawn
+        frame->next = HDL_NO_ELEMENT;
+        return 1;
     }
 
-    // Attribute count
-    uint8_t attrs = (uint8_t)data[(*pc)];
-    (*pc)++;
+    _hdl_layoutChildren(interface, frame);
 
-    for(int a = 0; a < attrs; a++) {
-        enum HDL_AttrIndex attrKey = (enum HDL_AttrIndex)data[(*pc)++];
-        enum HDL_Type attrType = (enum HDL_Type)data[(*pc)++];
-        uint8_t count = data[(*pc)++];
+    return 1;
+}
 
-        if(attrType == HDL_TYPE_BIND && attrKey != HDL_ATTR_BIND) {
+// Returns the next enabled child laid out by the frame's flex cursor, NULL when done
+struct HDL_Element *_hdl_nextChild (struct HDL_Interface *interface, struct _hdl_RenderFrame *frame) {
+    struct HDL_Element *element = frame->element;
+    const struct HDL_ElementDesc *desc = _hdl_desc(interface, element);
+    const struct HDL_Attrs *attrs = _hdl_attrs(interface, element);
 
-            el->bound_attrs[el->boundAttrCount].key = attrKey;
-            el->bound_attrs[el->boundAttrCount].count = count;
-            if(count == 1) {
-                el->bound_attrs[el->boundAttrCount].bind.value = *(uint16_t*)&data[*pc];
-                (*pc) += 2;
-            }
-            else {
-                el->bound_attrs[el->boundAttrCount].bind.values = HMALLOC(sizeof(uint16_t) * count);
-                for(int i = 0; i < count; i++) {
-                    el->bound_attrs[el->boundAttrCount].bind.values[i] = *(uint16_t*)&data[*pc];
-                    (*pc) += 2;
-                }
-            }
-            el->boundAttrCount++;
+    while(frame->next != HDL_NO_ELEMENT) {
+        struct HDL_Element *child = &interface->elements[frame->next];
+        frame->next = _hdl_desc(interface, child)->next_sibling;
 
+        if(child->disabled) {
+            if(child->flags & HDL_FLAG_VISIBLE)
+                _hdl_hideSubtree(interface, child);
             continue;
         }
 
+        if(child->flags & HDL_FLAG_STATIC)
+            return child;
 
-        // Type checks
-        uint8_t typeFail = 0;
+        child->x = frame->curFlexX;
+        child->y = frame->curFlexY;
 
-        switch(attrKey) {
-            // Numbers
-            // Integers (8bit)
-            case HDL_ATTR_FLEX:
-            case HDL_ATTR_FLEX_DIR:
-            case HDL_ATTR_SIZE:
-            case HDL_ATTR_ALIGN:
-            case HDL_ATTR_VALUE:
-            case HDL_ATTR_BORDER:
-            case HDL_ATTR_RADIUS:
-            case HDL_ATTR_SPRITE:
-            {
-                // Should be single 8-bit integer or binding
-                if(count > 1 || (attrType != HDL_TYPE_I8 && attrType != HDL_TYPE_BIND)) {
-                    // Incorrect value, ignored
-                    typeFail = 1;
-                }
-                break;
-            }
-            // Image/16-bit integer
-            case HDL_ATTR_IMG:
-            {
-                // Should be single u16
-                if(count > 1 || (attrType != HDL_TYPE_IMG && attrType != HDL_TYPE_I16)) {
-                    // Incorrect value, ignored
-                    typeFail = 1;
-                }
-                break;
-            }
-            // Boolean
-            case HDL_ATTR_DISABLED:
-            {
-                // Boolean
-                if((attrType != HDL_TYPE_BOOL && attrType != HDL_TYPE_BIND)) {
-                    typeFail = 1;
-                }
-                break;
+        if(desc->tag == HDL_TAG_SCROLL) {
+            // Own size along the scroll axis, a full page if not set
+            if(attrs->flexDir == HDL_FLEX_COLUMN) {
+                if(child->width == 0)
+                    child->width = element->width;
+                child->height = element->height;
+                frame->curFlexX += child->width;
             }
-            // Integers (8/16bit)
-            case HDL_ATTR_X:
-            case HDL_ATTR_Y:
-            case HDL_ATTR_WIDTH:
-            case HDL_ATTR_HEIGHT:
-            case HDL_ATTR_WIDGET:
-            {
-                // Should be single 8/16-bit integer
-                if(count > 1 || (attrType != HDL_TYPE_I8 && attrType != HDL_TYPE_I16 && attrType != HDL_TYPE_BIND)) {
-                    // Incorrect value, ignored
-                    typeFail = 1;
-                }
-                break;
+            else {
+                if(child->height == 0)
+                    child->height = element->height;
+                child->width = element->width;
+                frame->curFlexY += child->height;
             }
-            // Integers (8/16bit int array)
-            case HDL_ATTR_PADDING:
-            case HDL_ATTR_BIND:
-            {
-                if((attrType != HDL_TYPE_I8 && attrType != HDL_TYPE_I16 && attrType != HDL_TYPE_BIND)) {
-                    // Incorrect value, ignored
-                    typeFail = 1;
-                }
-                break;
+
+            // Scrolled out of the container
+            if(child->x > element->x + element->width || child->x + child->width < element->x ||
+                child->y > element->y + element->height || child->y + child->height < element->y) {
+                if(child->flags & HDL_FLAG_VISIBLE)
+                    _hdl_hideSubtree(interface, child);
+                continue;
             }
+            return child;
         }
 
-        // Save single integer value here
-        int32_t tmpVal = 0;
-        switch(attrType) {
-            case HDL_TYPE_BOOL:
-            case HDL_TYPE_I8:
-            {
-                tmpVal = *(int8_t*)&data[*pc];
-                break;
-            }
-            case HDL_TYPE_IMG:
-            case HDL_TYPE_I16:
-            case HDL_TYPE_BIND:
-            {
-                tmpVal = *(int16_t*)&data[*pc];
-                break;
+        if(attrs->flexDir == HDL_FLEX_COLUMN) {
+            int16_t addF = (uint16_t)ceilf((float)_hdl_attrs(interface, child)->flex / (float)frame->totalFlex * element->width);
+            // Set child width
+            child->width = addF;
+            // Height from parent
+            child->height = element->height;
+
+            frame->curFlexX += addF;
+        }
+        else if(attrs->flexDir == HDL_FLEX_ROW) {
+            int16_t addF = (uint16_t)ceilf((float)_hdl_attrs(interface, child)->flex / (float)frame->totalFlex * element->height);
+            // Set child height
+            child->height = addF;
+            // Width from parent
+            child->width = element->width;
+
+            frame->curFlexY += addF;
+        }
+
+        return child;
+    }
+    return NULL;
+}
+
+// Gets the border box of an element, inset by half of the parent padding
+void _hdl_elementBox (struct HDL_Interface *interface, struct HDL_Element *element, int16_t *x, int16_t *y, int16_t *w, int16_t *h) {
+    int8_t pad_x = 0;
+    int8_t pad_y = 0;
+
+    if(_hdl_desc(interface, element)->parent != HDL_NO_ELEMENT) {
+        pad_x = _hdl_attrs(interface, &interface->elements[_hdl_desc(interface, element)->parent])->padding_x;
+        pad_y = _hdl_attrs(interface, &interface->elements[_hdl_desc(interface, element)->parent])->padding_y;
+    }
+
+    int16_t x1 = element->x + pad_x/2;
+    int16_t x2 = element->x + element->width - pad_x/2;
+    int16_t y1 = element->y + pad_y/2;
+    int16_t y2 = element->y + element->height - pad_y/2;
+
+    if(x2 == interface->width)
+        x2 = interface->width - 1;
+
+    if(y2 == interface->height)
+        y2 = interface->height - 1;
+
+    *x = x1;
+    *y = y1;
+    *w = x2 - x1 + 1;
+    *h = y2 - y1 + 1;
+}
+
+// Fills the element background, called before its children are drawn
+void _hdl_drawBackground (struct HDL_Interface *interface, struct HDL_Element *element, uint8_t color) {
+    int16_t x, y, w, h;
+    _hdl_elementBox(interface, element, &x, &y, &w, &h);
+    const struct HDL_Attrs *attrs = _hdl_attrs(interface, element);
+
+    _hdl_setPaletteColor(interface, attrs->background != HDL_COLOR_NONE ? attrs->background : color);
+
+    if(attrs->radius > 0) {
+        _hdl_roundRect(interface, x, y, w, h, attrs->radius, 1, 1);
+    }
+    else {
+        _hdl_rect(interface, x, y, w, h);
+    }
+}
+
+// Returns 1 if the area intersects the clip rectangle or drawing is not clipped
+int _hdl_inClip (struct HDL_Interface *interface, int16_t x, int16_t y, int16_t w, int16_t h) {
+    if(!interface->_clipping)
+        return 1;
+
+    struct HDL_Bounds *clip = &interface->_clip;
+    return x < clip->x + clip->w && x + w > clip->x && y < clip->y + clip->h && y + h > clip->y;
+}
+
+// Intersects two areas, w and h are 0 if they do not overlap
+void _hdl_intersect (const struct HDL_Bounds *a, const struct HDL_Bounds *b, struct HDL_Bounds *out) {
+    int16_t x1 = a->x > b->x ? a->x : b->x;
+    int16_t y1 = a->y > b->y ? a->y : b->y;
+    int16_t x2 = a->x + a->w < b->x + b->w ? a->x + a->w : b->x + b->w;
+    int16_t y2 = a->y + a->h < b->y + b->h ? a->y + a->h : b->y + b->h;
+
+    out->x = x1;
+    out->y = y1;
+    out->w = x2 > x1 ? x2 - x1 : 0;
+    out->h = y2 > y1 ? y2 - y1 : 0;
+}
+
+// Gets the on-screen area inside the border of a scroll container
+void _hdl_viewport (struct HDL_Interface *interface, struct HDL_Element *element, struct HDL_Bounds *view) {
+    int16_t x, y, w, h;
+    _hdl_elementBox(interface, element, &x, &y, &w, &h);
+
+    int16_t border = _hdl_attrs(interface, element)->border;
+    x += border;
+    y += border;
+    w -= border * 2;
+    h -= border * 2;
+
+    // Limit to the screen
+    int16_t x2 = x + w < interface->width ? x + w : interface->width;
+    int16_t y2 = y + h < interface->height ? y + h : interface->height;
+    if(x < 0)
+        x = 0;
+    if(y < 0)
+        y = 0;
+
+    view->x = x;
+    view->y = y;
+    view->w = x2 > x ? x2 - x : 0;
+    view->h = y2 > y ? y2 - y : 0;
+}
+
+// Limits drawing to the viewport of a scroll container until _hdl_endScroll
+void _hdl_beginScroll (struct HDL_Interface *interface, struct HDL_Element *element) {
+    struct HDL_ElementExt *ext = _hdl_getExt(interface, element);
+    if(ext == NULL || ext->scroll == NULL)
+        return;
+
+    struct HDL_ScrollState *state = ext->scroll;
+    state->clip = interface->_clip;
+    state->clipping = interface->_clipping;
+    state->view = interface->_view;
+    state->viewing = interface->_viewing;
+
+    struct HDL_Bounds view;
+    _hdl_viewport(interface, element, &view);
+
+    if(interface->_viewing)
+        _hdl_intersect(&state->view, &view, &interface->_view);
+    else
+        interface->_view = view;
+
+    if(interface->_clipping)
+        _hdl_intersect(&state->clip, &interface->_view, &interface->_clip);
+    else
+        interface->_clip = interface->_view;
+
+    interface->_clipping = 1;
+    interface->_viewing = 1;
+}
+
+// Restores the clip of the scroll container's parent
+void _hdl_endScroll (struct HDL_Interface *interface, struct HDL_Element *element) {
+    struct HDL_ElementExt *ext = _hdl_getExt(interface, element);
+    if(ext == NULL || ext->scroll == NULL)
+        return;
+
+    interface->_clip = ext->scroll->clip;
+    interface->_clipping = ext->scroll->clipping;
+    interface->_view = ext->scroll->view;
+    interface->_viewing = ext->scroll->viewing;
+}
+
+/**
+ * @brief Collects the ink runs of a glyph at size 1, or draws them scaled when runs is NULL
+ * 
+ * @param interface 
+ * @param font 
+ * @param glyph 
+ * @param runs Run buffer or NULL to draw
+ * @param max Run buffer size
+ * @param x Screen position when drawing
+ * @param y Screen position when drawing
+ * @param size Scale when drawing
+ * @return uint16_t Run count, more than max if the runs did not fit
+ */
+uint16_t _hdl_glyphRuns (struct HDL_Interface *interface, const struct _hdl_Font *font, const struct HDL_Glyph *glyph, uint8_t (*runs)[3], uint16_t max, int16_t x, int16_t y, uint8_t size) {
+    uint16_t count = 0;
+
+    for(uint8_t row = 0; row < font->header->height; row++) {
+        const uint8_t *src = font->atlas + row * font->rowBytes;
+        int16_t start = -1;
+
+        for(uint16_t col = 0; col <= glyph->width; col++) {
+            uint16_t ax = glyph->x + col;
+            uint8_t ink = col < glyph->width && ax < font->header->atlasWidth && !((src[ax >> 3] >> (7 - (ax & 7))) & 1);
+
+            if(ink) {
+                if(start < 0)
+                    start = col;
+                continue;
             }
-            case HDL_TYPE_I32:
-            {
-                tmpVal = *(int32_t*)&data[*pc];
-                break;
+            if(start < 0)
+                continue;
+
+            if(runs == NULL) {
+                if(size == 1)
+                    _hdl_span(interface, x + start, y + row, col - start);
+                else
+                    _hdl_rect(interface, x + start * size, y + row * size, (col - start) * size, size);
             }
-            default:
-            {
-                tmpVal = 0;
-                break;
+            else {
+                if(count >= max)
+                    return max + 1;
+                runs[count][0] = start;
+                runs[count][1] = row;
+                runs[count][2] = col - start;
             }
+            count++;
+            start = -1;
         }
+    }
+    return count;
+}
 
-        if(!typeFail) {
-            switch(attrKey) {
-                case HDL_ATTR_X:
-                    el->attrs.x = tmpVal;
-                    break;
-                case HDL_ATTR_Y:
-                    el->attrs.y = tmpVal;
-                    break;
-                case HDL_ATTR_WIDTH:
-                    el->attrs.width = tmpVal;
-                    break;
-                case HDL_ATTR_HEIGHT:
-                    el->attrs.height = tmpVal;
-                    break;
-                case HDL_ATTR_FLEX:
-                    el->attrs.flex = tmpVal;
-                    break;
-                case HDL_ATTR_FLEX_DIR:
-                    el->attrs.flexDir = tmpVal;
-                    break;
-                case HDL_ATTR_BIND:
-                {
-                    el->bindings = HMALLOC(sizeof(uint16_t) * count);
-                    el->bind_count = count;
-                    for(int x = 0; x < count; x++) {
-                        el->bindings[x] = (uint16_t)((uint16_t*)&data[(*pc)])[x];
-                    }
-                    break;
-                }
-                case HDL_ATTR_IMG:
-                    el->attrs.image = tmpVal;
-                    break;
-                case HDL_ATTR_PADDING:
-                {
-                    if(count > 1) {
-                        // Paddings seperately
-                        if(attrType == HDL_TYPE_I8) {
-                            el->attrs.padding_x = (int8_t)((int8_t*)&data[(*pc)])[0];
-                            el->attrs.padding_y = (int8_t)((int8_t*)&data[(*pc)])[1];
-                        }
-                        else {
-                            el->attrs.padding_x = (int16_t)((int16_t*)&data[(*pc)])[0];
-                            el->attrs.padding_y = (int16_t)((int16_t*)&data[(*pc)])[1];
-                        }
-                    }
-                    else {
-                        // Both paddings from single value
-                        el->attrs.padding_x = tmpVal;
-                        el->attrs.padding_y = tmpVal;
-                    }
-                    break;
-                }
-                case HDL_ATTR_ALIGN:
-                    el->attrs.align = tmpVal;
-                    break;
-                case HDL_ATTR_DISABLED:
-                    el->attrs.disabled = tmpVal;
-                    break;
-                case HDL_ATTR_SIZE:
-                    el->attrs.size = tmpVal;
-                    break;
-                case HDL_ATTR_VALUE:
-                    el->attrs.value = tmpVal;
-                    break;
-                case HDL_ATTR_SPRITE:
-                    el->attrs.sprite = tmpVal;
-                    break;
-                case HDL_ATTR_BORDER:
-                    el->attrs.border = tmpVal;
-                    break;
-                case HDL_ATTR_RADIUS:
-                    el->attrs.radius = tmpVal;
-                    break;
-                case HDL_ATTR_WIDGET:
-                    el->attrs.widget = tmpVal;
-                    break;
+// Draws a glyph through the glyph run cache
+void _hdl_drawGlyph (struct HDL_Interface *interface, const struct _hdl_Font *font, uint8_t c, const struct HDL_Glyph *glyph, int16_t x, int16_t y, uint8_t size) {
+    struct HDL_GlyphCache *entry = NULL;
 
-            }
+    if(interface->_glyphs == NULL) {
+        if((interface->_glyphs = HMALLOC(sizeof(struct HDL_GlyphCache) * HDL_CONF_GLYPH_CACHE)) == NULL) {
+            _hdl_glyphRuns(interface, font, glyph, NULL, 0, x, y, size);
+            return;
         }
-        else {
-            //printf("TYPEFAIL: %i = %i at %X\n", attrKey, attrType, (*pc));
+        memset(interface->_glyphs, 0, sizeof(struct HDL_GlyphCache) * HDL_CONF_GLYPH_CACHE);
+    }
+
+    for(int i = 0; i < HDL_CONF_GLYPH_CACHE; i++) {
+        if(interface->_glyphs[i].font == font->bmp && interface->_glyphs[i].c == c) {
+            entry = &interface->_glyphs[i];
+            break;
         }
+    }
 
-        // Increment pc
-        if(attrType < sizeof(TYPE_SIZES)) {
-            if(attrType == HDL_TYPE_STRING) {
-                while(data[(*pc)++] != 0) {
-                    // Loop until null termination
-                }
-            }
-            else {
-                (*pc) += TYPE_SIZES[attrType] * count;
-            }
+    if(entry == NULL) {
+        // Replace the oldest entry
+        entry = &interface->_glyphs[interface->_glyphNext];
+        interface->_glyphNext = (interface->_glyphNext + 1) % HDL_CONF_GLYPH_CACHE;
+
+        uint16_t count = _hdl_glyphRuns(interface, font, glyph, entry->runs, HDL_CONF_GLYPH_RUNS, 0, 0, 1);
+        if(count > HDL_CONF_GLYPH_RUNS) {
+            // Too complex to cache
+            entry->font = NULL;
+            _hdl_glyphRuns(interface, font, glyph, NULL, 0, x, y, size);
+            return;
+        }
+        entry->font = font->bmp;
+        entry->c = c;
+        entry->count = count;
+    }
+
+    for(int i = 0; i < entry->count; i++) {
+        uint8_t *run = entry->runs[i];
+        if(size == 1)
+            _hdl_span(interface, x + run[0], y + run[1], run[2]);
+        else
+            _hdl_rect(interface, x + run[0] * size, y + run[1] * size, run[2] * size, size);
+    }
+}
+
+// Draws text with a core font
+void _hdl_fontText (struct HDL_Interface *interface, const struct _hdl_Font *font, const char *text, int16_t x, int16_t y, uint8_t size) {
+    int16_t height = font->header->height * size;
+    int16_t cx = x;
+
+    for(const uint8_t *c = (const uint8_t*)text; *c; c++) {
+        if(*c == '\n') {
+            cx = x;
+            y += height + size;
+            continue;
+        }
+
+        const struct HDL_Glyph *glyph = _hdl_fontGlyph(font, *c);
+        if(glyph == NULL)
+            continue;
+
+        if(glyph->width > 0 && _hdl_inClip(interface, cx, y, glyph->width * size, height))
+            _hdl_drawGlyph(interface, font, *c, glyph, cx, y, size);
+
+        cx += (glyph->advance + _hdl_fontKerning(font, c[0], c[1])) * size;
+    }
+}
+
+/**
+ * @brief Formats element content to the shared content buffer and calculates its aligned position
+ * 
+ * @param interface 
+ * @param element 
+ * @param ext Element extension
+ * @param x Aligned content position
+ * @param y Aligned content position
+ */
+void _hdl_layoutContent (struct HDL_Interface *interface, struct HDL_Element *element, struct HDL_ElementExt *ext, int16_t *x, int16_t *y) {
+    int8_t pad_x = 0;
+    int8_t pad_y = 0;
+
+    if(_hdl_desc(interface, element)->parent != HDL_NO_ELEMENT) {
+        pad_x = _hdl_attrs(interface, &interface->elements[_hdl_desc(interface, element)->parent])->padding_x;
+        pad_y = _hdl_attrs(interface, &interface->elements[_hdl_desc(interface, element)->parent])->padding_y;
+    }
+
+    // Set alignment point
+    int16_t align_x = 0;
+    int16_t align_y = 0;
+
+    uint8_t hzAlign = _hdl_attrs(interface, element)->align >> 4;
+    uint8_t vtAlign = _hdl_attrs(interface, element)->align & 0xF;
+
+    uint16_t contW = 0;
+    uint16_t contH = 0;
+
+    // Shared format buffer, content is drawn before the next element is formatted
+    char *content_buffer = interface->_contentBuffer;
+    memset(content_buffer, 0, HDL_CONF_CONTENT_BUFFER_SIZE);
+
+    if(ext->content != NULL) {
+        if(ext->bind_count > 0) {
+            _hdl_sprintf_bindings(content_buffer, HDL_CONF_CONTENT_BUFFER_SIZE, interface, ext);
+        }
+        else {
+            strncpy(content_buffer, ext->content, HDL_CONF_CONTENT_BUFFER_SIZE - 1);
+        }
+    }
+
+    // Resolved by HDL_Precompile
+    if(element->flags & HDL_FLAG_STATIC_CONTENT) {
+        *x = ext->contentX;
+        *y = ext->contentY;
+        return;
+    }
+
+    if(ext->content != NULL) {
+        // Get string size
+        struct _hdl_Font font;
+        _hdl_str_size(interface, _hdl_openFont(interface, ext->font, &font) ? NULL : &font, content_buffer, &contW, &contH);
+        contW *= _hdl_attrs(interface, element)->size;
+        contH *= _hdl_attrs(interface, element)->size;
+    }
+    if(ext->bitmap != NULL) {
+        // Get image size
+        uint16_t imgWidth = ext->bitmap->sprite_width * _hdl_attrs(interface, element)->size;
+        uint16_t imgHeight = ext->bitmap->sprite_height * _hdl_attrs(interface, element)->size;
+
+        if(contW < imgWidth) {
+            contW = imgWidth;
+        }
+        if(contH < imgHeight) {
+            contH = imgHeight;
+        }
+    }
+
+    int8_t pad_dir_x = 1;
+    int8_t pad_dir_y = 1;
+
+    // Y alignment, 0/default is middle
+    switch(vtAlign) {
+        case HDL_ALIGN_Y_TOP:
+        {
+            // Top
+            align_y = pad_y/2;
+            break;
+        }
+        case HDL_ALIGN_Y_BOTTOM:
+        {
+            // Bottom
+            align_y = element->height - contH - pad_y/2;
+            pad_dir_y = -1;
+            break;
+        }
+        default:
+        {
+            // Middle
+            align_y = (element->height / 2) - (contH / 2);
+            break;
+        }
+    }
+    // X alignment, 0/default is center
+    switch(hzAlign) {
+        case HDL_ALIGN_X_LEFT:
+        {
+            align_x = pad_x/2;
+            break;
+        }
+        case HDL_ALIGN_X_RIGHT:
+        {
+            align_x = element->width - contW - pad_x/2;
+            pad_dir_x = -1;
+            break;
+        }
+        default:
+        {
+            // Center
+            align_x = (element->width / 2) - (contW / 2);
+            break;
+        }
+    }
+
+    *x = align_x + element->x + _hdl_attrs(interface, element)->padding_x * pad_dir_x;
+    *y = align_y + element->y + _hdl_attrs(interface, element)->padding_y * pad_dir_y;
+}
+
+// Keeps the drawn text of an element for diffing
+void _hdl_storeText (struct HDL_ElementExt *ext, const char *text, int16_t x, int16_t y) {
+    struct HDL_TextCache *cache = ext->text;
+    if(cache == NULL)
+        return;
+
+    uint16_t len = strlen(text) + 1;
+    if(len > cache->cap) {
+        if(cache->text != NULL)
+            HFREE(cache->text);
+        cache->text = HMALLOC(len);
+        cache->cap = cache->text != NULL ? len : 0;
+        if(cache->text == NULL)
+            return;
+    }
+    memcpy(cache->text, text, len);
+    cache->x = x;
+    cache->y = y;
+}
+
+/**
+ * @brief Draws text from the content buffer. When clipped, only the character cells 
+ * in the clip rectangle are drawn, one substring per line
+ * 
+ * @param interface 
+ * @param font Core font, NULL to draw with f_text
+ * @param x Text position
+ * @param y Text position
+ * @param size Font size
+ */
+void _hdl_drawText (struct HDL_Interface *interface, const struct _hdl_Font *font, int16_t x, int16_t y, uint8_t size) {
+    char *text = interface->_contentBuffer;
+
+    if(font != NULL) {
+        _hdl_fontText(interface, font, text, x, y, size);
+        return;
+    }
+    if(interface->f_text == NULL)
+        return;
+
+    _hdl_flushSpans(interface);
+
+    if(!interface->_clipping) {
+        interface->f_text(x, y, text, size);
+        return;
+    }
+
+    struct HDL_Bounds *clip = &interface->_clip;
+    struct HDL_Bounds *view = &interface->_view;
+    int16_t cw = (interface->textWidth + 1) * size;
+    int16_t ch = (interface->textHeight + 1) * size;
+
+    for(char *line = text; line != NULL; y += ch) {
+        char *end = strchr(line, '\n');
+        int16_t len = end != NULL ? end - line : (int16_t)strlen(line);
+
+        // Only whole lines inside a scroll container
+        uint8_t inView = !interface->_viewing || (y >= view->y && y + ch <= view->y + view->h);
+
+        if(inView && y < clip->y + clip->h && y + ch > clip->y && x < clip->x + clip->w) {
+            // Cells in the clip rectangle
+            int16_t c0 = clip->x > x ? (clip->x - x) / cw : 0;
+            int16_t c1 = (clip->x + clip->w - x + cw - 1) / cw;
+            if(interface->_viewing) {
+                // Only whole cells inside a scroll container
+                if(view->x > x && c0 < (view->x - x + cw - 1) / cw)
+                    c0 = (view->x - x + cw - 1) / cw;
+                if(c1 > (view->x + view->w - x) / cw)
+                    c1 = (view->x + view->w - x) / cw;
+            }
+            if(c1 > len)
+                c1 = len;
+
+            if(c0 < c1) {
+                char saved = line[c1];
+                line[c1] = 0;
+                interface->f_text(x + c0 * cw, y, line + c0, size);
+                line[c1] = saved;
+            }
+        }
+        line = end != NULL ? end + 1 : NULL;
+    }
+}
+
+// Returns the ring buffer bound to a chart, NULL if none
+const struct HDL_Ring *_hdl_chartRing (struct HDL_Interface *interface, struct HDL_ElementExt *ext) {
+    if(ext->bind_count == 0)
+        return NULL;
+    struct HDL_Binding *binding = HDL_GetBinding(interface, ext->bindings[0]);
+    if(binding == NULL || binding->type != HDL_TYPE_RING)
+        return NULL;
+    return (const struct HDL_Ring*)binding->data;
+}
+
+// Returns the samples per column of a chart, the whole buffer fits the plot
+uint16_t _hdl_chartStep (const struct HDL_Ring *ring, uint16_t width) {
+    uint16_t step = (ring->capacity + width - 1) / width;
+    return step > 0 ? step : 1;
+}
+
+// Maps a sample to a row of the plot
+int16_t _hdl_chartY (const struct HDL_ChartState *state, const struct HDL_Bounds *plot, int16_t value) {
+    int32_t range = state->max > state->min ? state->max - state->min : 1;
+    int32_t y = (int32_t)(value - state->min) * (plot->h - 1) / range;
+    if(y < 0)
+        y = 0;
+    if(y > plot->h - 1)
+        y = plot->h - 1;
+    return plot->y + plot->h - 1 - y;
+}
+
+/**
+ * @brief Draws a chart as one vertical segment per column, spanning the minimum and maximum of its samples.
+ * Column extremes are cached, only columns with new or overwritten samples are read from the buffer
+ * 
+ * @param interface 
+ * @param element 
+ * @param ext Extension with the chart state
+ */
+void _hdl_drawChart (struct HDL_Interface *interface, struct HDL_Element *element, struct HDL_ElementExt *ext) {
+    struct HDL_ChartState *state = ext->chart;
+    const struct HDL_Ring *ring = _hdl_chartRing(interface, ext);
+    struct HDL_Bounds plot;
+    _hdl_viewport(interface, element, &plot);
+
+    if(ring == NULL || ring->capacity == 0 || plot.w == 0 || plot.h == 0)
+        return;
+
+    uint16_t step = _hdl_chartStep(ring, plot.w);
+    if(state->columns == NULL || state->width != plot.w || state->step != step) {
+        if(state->columns != NULL)
+            HFREE(state->columns);
+        state->columns = HMALLOC(plot.w * 2 * sizeof(int16_t));
+        if(state->columns == NULL)
+            return;
+        state->width = plot.w;
+        state->step = step;
+        state->valid = 0;
+    }
+    if(ring->written < state->written)
+        state->valid = 0;
+    if(ring->written == 0)
+        return;
+
+    // Newest column is on the right edge
+    int32_t last = (ring->written - 1) / step;
+    int32_t first = last - plot.w + 1;
+    // Oldest sample still in the buffer and its column, which loses samples as the buffer wraps
+    uint32_t start = ring->written > ring->capacity ? ring->written - ring->capacity : 0;
+    int32_t truncated = start / step;
+    // Columns that received samples since the last draw
+    int32_t fresh = state->valid ? (int32_t)(state->written / step) : first;
+
+    int16_t prevMin = 1, prevMax = 0;
+    for(int32_t k = first; k <= last; k++) {
+        int16_t *col = &state->columns[((k % plot.w + plot.w) % plot.w) * 2];
+
+        if(k <= truncated || k >= fresh) {
+            col[0] = 1;
+            col[1] = 0;
+            uint32_t s0 = k < 0 ? 0 : (uint32_t)k * step;
+            uint32_t s1 = s0 + step < ring->written ? s0 + step : ring->written;
+            if(k < 0)
+                s1 = 0;
+            for(uint32_t s = s0 < start ? start : s0; s < s1; s++) {
+                int16_t v = ring->samples[s % ring->capacity];
+                if(col[0] > col[1]) {
+                    col[0] = v;
+                    col[1] = v;
+                }
+                else if(v < col[0]) {
+                    col[0] = v;
+                }
+                else if(v > col[1]) {
+                    col[1] = v;
+                }
+            }
+        }
+
+        int16_t lo = col[0], hi = col[1];
+        if(lo <= hi) {
+            // Joined to the previous column
+            if(prevMin <= prevMax) {
+                if(prevMax < lo)
+                    lo = prevMax;
+                if(prevMin > hi)
+                    hi = prevMin;
+            }
+            int16_t x = plot.x + (k - first);
+            int16_t y1 = _hdl_chartY(state, &plot, hi);
+            int16_t y2 = _hdl_chartY(state, &plot, lo);
+            _hdl_rect(interface, x, y1, 1, y2 - y1 + 1);
+        }
+        prevMin = col[0];
+        prevMax = col[1];
+    }
+
+    state->written = ring->written;
+    state->valid = 1;
+}
+
+// Draws the element itself with its foreground color, called after its children have been drawn
+void _hdl_drawElement (struct HDL_Interface *interface, struct HDL_Element *element, uint8_t color) {
+    struct HDL_ElementExt *ext = _hdl_getExt(interface, element);
+    const struct HDL_Attrs *attrs = _hdl_attrs(interface, element);
+
+    element->flags |= HDL_FLAG_VISIBLE;
+
+    // Nothing to draw
+    if(ext == NULL && attrs->border == 0)
+        return;
+
+    _hdl_setPaletteColor(interface, color);
+
+    // DEBUG lines
+    /*
+    interface->f_hline(element->x, element->y, element->width);
+    interface->f_hline(element->x, element->y + element->height, element->width);
+
+    interface->f_vline(element->x, element->y, element->height);
+    interface->f_vline(element->x + element->width, element->y, element->height);
+    */
+
+    if(attrs->border > 0) {
+        int16_t x, y, w, h;
+        _hdl_elementBox(interface, element, &x, &y, &w, &h);
+
+        int16_t border = attrs->border;
+
+        if(attrs->radius > 0) {
+            // Rounded corners are rasterized by the core
+            _hdl_roundRect(interface, x, y, w, h, attrs->radius, border, 0);
+        }
+        else if(border * 2 >= w || border * 2 >= h) {
+            _hdl_rect(interface, x, y, w, h);
+        }
+        else {
+            // Top, bottom, left, right
+            _hdl_rect(interface, x, y, w, border);
+            _hdl_rect(interface, x, y + h - border, w, border);
+            _hdl_rect(interface, x, y + border, border, h - border * 2);
+            _hdl_rect(interface, x + w - border, y + border, border, h - border * 2);
+        }
+    }
+
+    if(ext == NULL)
+        return;
+
+    int16_t aligned_x, aligned_y;
+    _hdl_layoutContent(interface, element, ext, &aligned_x, &aligned_y);
+
+    if(ext->content != NULL) {
+        struct _hdl_Font font;
+        _hdl_drawText(interface, _hdl_openFont(interface, ext->font, &font) ? NULL : &font, aligned_x, aligned_y, attrs->size);
+        _hdl_storeText(ext, interface->_contentBuffer, aligned_x, aligned_y);
+    }
+    if(ext->bitmap != NULL) {
+        _hdl_drawBitmap(interface, ext->bitmap, ext->spriteX, ext->spriteY, aligned_x, aligned_y, attrs->size);
+    }
+    if(ext->widget != NULL && _hdl_inClip(interface, element->x, element->y, element->width + 1, element->height + 1)) {
+        // Palette bitmaps change the color
+        _hdl_setPaletteColor(interface, color);
+        _hdl_flushSpans(interface);
+        ext->widget->widget(interface, (const struct HDL_Element*)element);
+        // Widget may set its own color
+        interface->_color = HDL_COLOR_UNKNOWN;
+    }
+    if(ext->chart != NULL) {
+        _hdl_setPaletteColor(interface, color);
+        _hdl_drawChart(interface, element, ext);
+    }
+}
+
+// Returns the dependency bit of a binding
+uint32_t _hdl_bindingMask (struct HDL_Interface *interface, uint16_t id) {
+    struct HDL_Binding *binding = HDL_GetBinding(interface, id);
+    if(binding == NULL)
+        return 0;
+    return 1UL << ((binding - interface->bindings) % 32);
+}
+
+// Returns the index after the last element of the subtree
+uint16_t _hdl_subtreeEnd (struct HDL_Interface *interface, struct HDL_Element *element) {
+    // Pre-order: the subtree ends at the next sibling of the element or its closest ancestor
+    while(_hdl_desc(interface, element)->next_sibling == HDL_NO_ELEMENT) {
+        if(_hdl_desc(interface, element)->parent == HDL_NO_ELEMENT)
+            return interface->elementCount;
+        element = &interface->elements[_hdl_desc(interface, element)->parent];
+    }
+    return _hdl_desc(interface, element)->next_sibling;
+}
+
+// Clears the visible flag of a subtree that is not drawn
+void _hdl_hideSubtree (struct HDL_Interface *interface, struct HDL_Element *element) {
+    uint16_t end = _hdl_subtreeEnd(interface, element);
+    for(uint16_t i = element - interface->elements; i < end; i++) {
+        interface->elements[i].flags &= ~HDL_FLAG_VISIBLE;
+    }
+}
+
+// Collects the binding slots a subtree depends on
+uint32_t _hdl_subtreeDeps (struct HDL_Interface *interface, struct HDL_Element *element) {
+    uint32_t deps = 0;
+    uint16_t end = _hdl_subtreeEnd(interface, element);
+
+    for(uint16_t i = element - interface->elements; i < end; i++) {
+        struct HDL_ElementExt *ext = _hdl_getExt(interface, &interface->elements[i]);
+        if(ext == NULL)
+            continue;
+
+        for(int b = 0; b < ext->bind_count; b++) {
+            deps |= _hdl_bindingMask(interface, ext->bindings[b]);
+        }
+        for(int a = 0; a < ext->boundAttrCount; a++) {
+            struct HDL_AttrBind *battr = &interface->attrBinds[ext->boundAttrs + a];
+            if(battr->count == 1) {
+                deps |= _hdl_bindingMask(interface, battr->bind.value);
+            }
+            else {
+                for(int v = 0; v < battr->count; v++) {
+                    deps |= _hdl_bindingMask(interface, battr->bind.values[v]);
+                }
+            }
+        }
+    }
+    return deps;
+}
+
+/**
+ * @brief Composites a cached subtree or starts rendering it to its surface
+ * 
+ * @param interface 
+ * @param element Element with HDL_FLAG_CACHE, already laid out
+ * @return int 1 if the subtree was composited from the surface and should be skipped
+ */
+int _hdl_beginCache (struct HDL_Interface *interface, struct HDL_Element *element) {
+    struct HDL_ElementExt *ext = _hdl_getExt(interface, element);
+
+    if(ext == NULL || ext->cache == NULL || interface->_captureRoot != NULL)
+        return 0;
+    if(interface->f_surfaceCreate == NULL || interface->f_surfaceSelect == NULL || interface->f_surfaceBlit == NULL)
+        return 0;
+
+    struct HDL_SurfaceCache *cache = ext->cache;
+    uint8_t sameBounds = cache->surface >= 0 &&
+        cache->x == element->x && cache->y == element->y &&
+        cache->w == element->width + 1 && cache->h == element->height + 1;
+
+    _hdl_flushSpans(interface);
+
+    if(sameBounds && cache->valid && !(cache->deps & interface->_changedSlots)) {
+        interface->f_surfaceBlit(cache->surface);
+        cache->fresh = 1;
+        return 1;
+    }
+
+    if(!sameBounds) {
+        if(cache->surface >= 0 && interface->f_surfaceFree != NULL)
+            interface->f_surfaceFree(cache->surface);
+
+        cache->x = element->x;
+        cache->y = element->y;
+        cache->w = element->width + 1;
+        cache->h = element->height + 1;
+        cache->surface = interface->f_surfaceCreate(cache->x, cache->y, cache->w, cache->h);
+        if(cache->surface < 0) {
+            // No surface available, draw directly
+            cache->valid = 0;
+            return 0;
+        }
+    }
+
+    cache->deps = _hdl_subtreeDeps(interface, element);
+    cache->valid = 0;
+    cache->fresh = 1;
+
+    interface->f_surfaceSelect(cache->surface);
+    interface->f_clear(cache->x, cache->y, cache->w, cache->h);
+    interface->_captureRoot = element;
+    return 0;
+}
+
+// Finishes rendering a cached subtree and composites it
+void _hdl_endCache (struct HDL_Interface *interface, struct HDL_Element *element) {
+    struct HDL_SurfaceCache *cache = _hdl_getExt(interface, element)->cache;
+
+    _hdl_flushSpans(interface);
+    interface->f_surfaceSelect(-1);
+    interface->_captureRoot = NULL;
+    cache->valid = 1;
+    interface->f_surfaceBlit(cache->surface);
+}
+
+// Enters an element. Returns 1 if its children should be visited and the element drawn
+int _hdl_visitElement (struct HDL_Interface *interface, struct _hdl_RenderFrame *frame) {
+    if(!_hdl_enterElement(interface, frame))
+        return 0;
+
+    // Partial updates draw cached subtrees directly
+    if((frame->element->flags & HDL_FLAG_CACHE) && !interface->_clipping && !interface->_inList && _hdl_beginCache(interface, frame->element))
+        return 0;
+
+    if(_hdl_attrs(interface, frame->element)->fill || _hdl_attrs(interface, frame->element)->background != HDL_COLOR_NONE)
+        _hdl_drawBackground(interface, frame->element, frame->color);
+
+    if(_hdl_desc(interface, frame->element)->tag == HDL_TAG_SCROLL)
+        _hdl_beginScroll(interface, frame->element);
+
+    return 1;
+}
+
+struct HDL_Element *_hdl_nextRow (struct HDL_Interface *interface, struct _hdl_RenderFrame *frame);
+
+// Starts a traversal frame
+void _hdl_pushFrame (struct _hdl_RenderFrame *frame, struct HDL_Element *element, uint8_t color) {
+    frame->element = element;
+    frame->color = color;
+    frame->row = 0;
+    frame->inRow = 0;
+}
+
+/**
+ * @brief Lays out and draws the element tree without recursion.
+ * Children are drawn before their parent, stack usage is bounded by HDL_CONF_MAX_DEPTH
+ * 
+ * @param interface 
+ * @param root 
+ * @param color Inherited foreground color index
+ * @return int 0 or HDL_ERR_DEPTH if a subtree was skipped
+ */
+int _hdl_handleElement (struct HDL_Interface *interface, struct HDL_Element *root, uint8_t color) {
+    struct _hdl_RenderFrame stack[HDL_CONF_MAX_DEPTH];
+    int depth = 0;
+    int err = 0;
+
+    _hdl_pushFrame(&stack[0], root, color);
+    if(!_hdl_visitElement(interface, &stack[0]))
+        return 0;
+    depth = 1;
+
+    while(depth > 0) {
+        struct _hdl_RenderFrame *frame = &stack[depth - 1];
+        struct HDL_Element *child = _hdl_nextChild(interface, frame);
+
+        // List rows follow the children
+        if(child == NULL && _hdl_desc(interface, frame->element)->tag == HDL_TAG_LIST)
+            child = _hdl_nextRow(interface, frame);
+
+        if(child == NULL) {
+            // All children drawn
+            if(_hdl_desc(interface, frame->element)->tag == HDL_TAG_SCROLL)
+                _hdl_endScroll(interface, frame->element);
+            _hdl_drawElement(interface, frame->element, frame->color);
+            if(frame->element == interface->_captureRoot)
+                _hdl_endCache(interface, frame->element);
+            depth--;
+            continue;
+        }
+
+        if(depth >= HDL_CONF_MAX_DEPTH) {
+            // Build rejects deeper documents, skip the subtree
+            err = HDL_ERR_DEPTH;
+            continue;
+        }
+
+        _hdl_pushFrame(&stack[depth], child, frame->color);
+        if(_hdl_visitElement(interface, &stack[depth])) {
+            depth++;
+        }
+    }
+
+    _hdl_flushSpans(interface);
+    return err;
+}
+
+// Returns the array bound to a list, NULL if none
+const struct HDL_Array *_hdl_listArray (struct HDL_Interface *interface, struct HDL_ElementExt *ext) {
+    if(ext->bind_count == 0)
+        return NULL;
+    struct HDL_Binding *binding = HDL_GetBinding(interface, ext->bindings[0]);
+    if(binding == NULL || binding->type != HDL_TYPE_ARRAY)
+        return NULL;
+    return (const struct HDL_Array*)binding->data;
+}
+
+// Returns the row pitch of a list, taken from the template before rows overwrite its bounds
+uint16_t _hdl_rowHeight (struct HDL_Interface *interface, struct HDL_Element *list, struct HDL_ElementExt *ext) {
+    if(ext->list->rowHeight == 0) {
+        struct HDL_Element *template = &interface->elements[_hdl_desc(interface, list)->first_child];
+        ext->list->rowHeight = template->height > 0 ? template->height : interface->textHeight + 1;
+    }
+    return ext->list->rowHeight;
+}
+
+// FNV-1a hash of data, continuing from hash
+uint32_t _hdl_fnv (uint32_t hash, const uint8_t *data, uint32_t len) {
+    for(uint32_t i = 0; i < len; i++) {
+        hash = (hash ^ data[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+#define HDL_FNV_INIT 2166136261UL
+
+// Returns the data hash of a list row, 0 if there is no item
+uint32_t _hdl_rowHash (const struct HDL_Array *array, uint16_t index) {
+    const uint8_t *item = _hdl_arrayItem(array, index);
+    if(item == NULL)
+        return 0;
+
+    uint16_t len = array->type == HDL_TYPE_STRING ? strlen((const char*)item) : TYPE_SIZES[array->type];
+    uint32_t hash = _hdl_fnv(HDL_FNV_INIT, item, len);
+    return hash != 0 ? hash : 1;
+}
+
+/**
+ * @brief Lays out the list template for the next visible row. The template subtree is drawn again for every row
+ * and its content bound to the list array shows the item of the row. Rows are drawn on the work stack of the
+ * list, so nested lists stay within HDL_CONF_MAX_DEPTH
+ * 
+ * @param interface 
+ * @param frame Frame of the list, already laid out
+ * @return struct HDL_Element* Template to draw, NULL when all rows are drawn
+ */
+struct HDL_Element *_hdl_nextRow (struct HDL_Interface *interface, struct _hdl_RenderFrame *frame) {
+    struct HDL_Element *list = frame->element;
+    struct HDL_ElementExt *ext = _hdl_getExt(interface, list);
+    if(ext == NULL || ext->list == NULL || _hdl_desc(interface, list)->first_child == HDL_NO_ELEMENT)
+        return NULL;
+
+    // Previous row is done
+    if(frame->inRow) {
+        interface->_inList--;
+        frame->inRow = 0;
+    }
+    if(frame->row == 0)
+        frame->savedRow = interface->_listRow;
+
+    struct HDL_Element *template = &interface->elements[_hdl_desc(interface, list)->first_child];
+    const struct HDL_Array *array = _hdl_listArray(interface, ext);
+    uint16_t rowH = _hdl_rowHeight(interface, list, ext);
+    uint16_t rows = (list->height + 1) / rowH;
+
+    while(frame->row < rows) {
+        uint16_t r = frame->row++;
+        uint16_t index = _hdl_attrs(interface, list)->scroll + r;
+        uint32_t hash = _hdl_rowHash(array, index);
+        if(r < HDL_CONF_LIST_ROWS)
+            ext->list->rows[r] = hash;
+
+        int16_t y = list->y + r * rowH;
+        if(hash == 0 || !_hdl_inClip(interface, list->x, y, list->width + 1, rowH + 1))
+            continue;
+
+        template->x = list->x;
+        template->y = y;
+        template->width = list->width;
+        template->height = rowH;
+
+        interface->_listRow = index;
+        interface->_inList++;
+        frame->inRow = 1;
+        return template;
+    }
+
+    interface->_listRow = frame->savedRow;
+    return NULL;
+}
+
+// Initializes an element and its description to default values
+void HDL_InitElement (struct HDL_ElementDesc *desc, struct HDL_Element *element) {
+    if(desc == NULL || element == NULL)
+        return;
+
+    memset(element, 0, sizeof(struct HDL_Element));
+    memset(desc, 0, sizeof(struct HDL_ElementDesc));
+    desc->attrs.flex = 1;
+    desc->attrs.flexDir = HDL_FLEX_ROW;
+    desc->attrs.image = 0xFFFF;
+    desc->attrs.size = 1;
+    desc->attrs.widget = 0xFFFF;
+    desc->attrs.font = 0xFFFF;
+    desc->attrs.color = HDL_COLOR_NONE;
+    desc->attrs.background = HDL_COLOR_NONE;
+    desc->parent = HDL_NO_ELEMENT;
+    desc->first_child = HDL_NO_ELEMENT;
+    desc->next_sibling = HDL_NO_ELEMENT;
+    element->ext = HDL_NO_EXT;
+
+}
+
+int HDL_SetBinding (struct HDL_Interface *interface, const char *key, uint16_t id, void *binding, enum HDL_Type type) {
+
+    for(int i = 0; i < HDL_CONF_MAX_BINDINGS; i++) {
+        if(interface->bindings[i].id == 0xFFFF) {
+            interface->bindings[i].id = id;
+            interface->bindings[i].data = binding;
+            interface->bindings[i].type = type;
+
+            #ifdef HDL_CONF_BIND_COPIES
+            interface->_bindings_cpy[i].id = id;
+            interface->_bindings_cpy[i].data = HMALLOC(TYPE_SIZES[type]);
+            memcpy(interface->_bindings_cpy[i].data, binding, TYPE_SIZES[type]);
+            interface->_bindings_cpy[i].type = type;
+            #endif
+
+            // Cached subtrees may depend on the new binding
+            interface->_changedSlots = 0xFFFFFFFF;
+
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+const char *HDL_GetContent (struct HDL_Interface *interface, const struct HDL_Element *element) {
+    struct HDL_ElementExt *ext = _hdl_getExt(interface, element);
+    return ext != NULL ? ext->content : NULL;
+}
+
+const struct HDL_ElementDesc *HDL_GetDesc (struct HDL_Interface *interface, const struct HDL_Element *element) {
+    return _hdl_desc(interface, element);
+}
+
+const struct HDL_Attrs *HDL_GetAttrs (struct HDL_Interface *interface, const struct HDL_Element *element) {
+    return _hdl_attrs(interface, element);
+}
+
+struct HDL_Binding *HDL_GetBinding (struct HDL_Interface *interface, uint16_t id) {
+
+    for(int i = 0; i < HDL_CONF_MAX_BINDINGS; i++) {
+        if(interface->bindings[i].id == id) {
+            return &interface->bindings[i];
+        }
+    }
+    return NULL;
+}
+
+// Grows an array to hold at least count items
+int _hdl_grow (void **array, uint16_t *capacity, uint16_t count, size_t itemSize) {
+    if(count <= *capacity)
+        return 0;
+
+    uint32_t newCapacity = *capacity > 0 ? *capacity : 8;
+    while(newCapacity < count) {
+        newCapacity *= 2;
+    }
+    if(newCapacity > 0xFFFF)
+        newCapacity = 0xFFFF;
+
+    void *grown = HMALLOC(newCapacity * itemSize);
+    if(grown == NULL)
+        return HDL_ERR_MEMORY;
+
+    if(*array != NULL) {
+        memcpy(grown, *array, *capacity * itemSize);
+        HFREE(*array);
+    }
+    *array = grown;
+    *capacity = newCapacity;
+    return 0;
+}
+
+// Document data interned in an asset store
+struct _hdl_Blob {
+    uint32_t hash;
+    uint32_t size;
+    // Kept copies
+    uint16_t refs;
+    uint8_t data[] __attribute__((aligned(8)));
+};
+
+// Returns the index of the first interned blob with a hash not below hash
+uint16_t _hdl_findBlob (const struct HDL_AssetStore *store, uint32_t hash) {
+    uint16_t lo = 0, hi = store->stats.blobs;
+    while(lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if(store->_blobs[mid]->hash < hash)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Returns the interned copy of data, adding it to the store if not found. NULL if out of memory
+const void *_hdl_intern (struct HDL_AssetStore *store, const uint8_t *data, uint32_t len) {
+    uint32_t hash = _hdl_fnv(HDL_FNV_INIT, data, len);
+    uint16_t index = _hdl_findBlob(store, hash);
+
+    for(uint16_t i = index; i < store->stats.blobs && store->_blobs[i]->hash == hash; i++) {
+        struct _hdl_Blob *blob = store->_blobs[i];
+        if(blob->size == len && blob->refs < 0xFFFF && memcmp(blob->data, data, len) == 0) {
+            blob->refs++;
+            store->stats.saved += len;
+            return blob->data;
+        }
+    }
+
+    if(store->stats.blobs == 0xFFFF || _hdl_grow((void**)&store->_blobs, &store->_blobCap, store->stats.blobs + 1, sizeof(struct _hdl_Blob*)))
+        return NULL;
+
+    struct _hdl_Blob *blob = HMALLOC(sizeof(struct _hdl_Blob) + len);
+    if(blob == NULL)
+        return NULL;
+    blob->hash = hash;
+    blob->size = len;
+    blob->refs = 1;
+    memcpy(blob->data, data, len);
+
+    memmove(&store->_blobs[index + 1], &store->_blobs[index], (store->stats.blobs - index) * sizeof(struct _hdl_Blob*));
+    store->_blobs[index] = blob;
+    store->stats.blobs++;
+    store->stats.bytes += len;
+    return blob->data;
+}
+
+// Releases data returned by _hdl_intern, freeing it with the last copy
+void _hdl_unintern (struct HDL_AssetStore *store, const void *data) {
+    struct _hdl_Blob *blob = (struct _hdl_Blob*)((const uint8_t*)data - offsetof(struct _hdl_Blob, data));
+    if(--blob->refs > 0) {
+        store->stats.saved -= blob->size;
+        return;
+    }
+
+    for(uint16_t i = _hdl_findBlob(store, blob->hash); i < store->stats.blobs; i++) {
+        if(store->_blobs[i] == blob) {
+            memmove(&store->_blobs[i], &store->_blobs[i + 1], (store->stats.blobs - i - 1) * sizeof(struct _hdl_Blob*));
+            store->stats.blobs--;
+            break;
+        }
+    }
+    store->stats.bytes -= blob->size;
+    HFREE(blob);
+}
+
+// Returns document data kept for the built tree, referenced in place for a resident document,
+// interned in the attached asset store and copied otherwise. NULL if out of memory
+const void *_hdl_keep (struct HDL_Interface *interface, const uint8_t *data, uint32_t len) {
+    if(interface->residentDocument)
+        return data;
+
+    if(interface->assets != NULL)
+        return _hdl_intern(interface->assets, data, len);
+
+    void *copy = HMALLOC(len);
+    if(copy != NULL)
+        memcpy(copy, data, len);
+    return copy;
+}
+
+// Frees data returned by _hdl_keep
+void _hdl_release (struct HDL_Interface *interface, const void *data) {
+    if(data == NULL || interface->residentDocument)
+        return;
+
+    if(interface->assets != NULL)
+        _hdl_unintern(interface->assets, data);
+    else
+        HFREE((void*)data);
+}
+
+// Returns the element extension, adding one if the element has none
+struct HDL_ElementExt *_hdl_addExt (struct HDL_Interface *interface, struct HDL_Element *el) {
+    if(el->ext != HDL_NO_EXT)
+        return &interface->elementExt[el->ext];
+
+    if(interface->elementExtCount >= HDL_NO_EXT)
+        return NULL;
+    if(_hdl_grow((void**)&interface->elementExt, &interface->_elementExtCap, interface->elementExtCount + 1, sizeof(struct HDL_ElementExt)))
+        return NULL;
+
+    el->ext = interface->elementExtCount++;
+    struct HDL_ElementExt *ext = &interface->elementExt[el->ext];
+    memset(ext, 0, sizeof(struct HDL_ElementExt));
+    ext->boundAttrs = interface->attrBindCount;
+    return ext;
+}
+
+// Adds the extensions holding the runtime state of a parsed element
+int _hdl_buildStates (struct HDL_Interface *interface, struct HDL_Element *el, const struct HDL_ElementDesc *desc, const int16_t *range) {
+    // Bound values are applied to a copy, the description is not written after the build
+    struct HDL_ElementExt *ext = _hdl_getExt(interface, el);
+    if(ext != NULL && ext->boundAttrCount > 0) {
+        ext->attrs = HMALLOC(sizeof(struct HDL_Attrs));
+        if(ext->attrs == NULL)
+            return HDL_ERR_MEMORY;
+        memcpy(ext->attrs, &desc->attrs, sizeof(struct HDL_Attrs));
+    }
+
+    // References are resolved to the extension
+    if(desc->attrs.image != 0xFFFF || desc->attrs.widget != 0xFFFF || desc->attrs.font != 0xFFFF) {
+        if(_hdl_addExt(interface, el) == NULL)
+            return HDL_ERR_MEMORY;
+    }
+
+    // Surface cache
+    if(el->flags & HDL_FLAG_CACHE) {
+        if((ext = _hdl_addExt(interface, el)) == NULL)
+            return HDL_ERR_MEMORY;
+        ext->cache = HMALLOC(sizeof(struct HDL_SurfaceCache));
+        if(ext->cache == NULL)
+            return HDL_ERR_MEMORY;
+        memset(ext->cache, 0, sizeof(struct HDL_SurfaceCache));
+        ext->cache->surface = -1;
+    }
+
+    // Drawn rows of a list
+    if(desc->tag == HDL_TAG_LIST) {
+        if((ext = _hdl_addExt(interface, el)) == NULL)
+            return HDL_ERR_MEMORY;
+        ext->list = HMALLOC(sizeof(struct HDL_ListState));
+        if(ext->list == NULL)
+            return HDL_ERR_MEMORY;
+        memset(ext->list, 0, sizeof(struct HDL_ListState));
+    }
+
+    // Column cache of a chart
+    if(desc->tag == HDL_TAG_CHART) {
+        if((ext = _hdl_addExt(interface, el)) == NULL)
+            return HDL_ERR_MEMORY;
+        ext->chart = HMALLOC(sizeof(struct HDL_ChartState));
+        if(ext->chart == NULL)
+            return HDL_ERR_MEMORY;
+        memset(ext->chart, 0, sizeof(struct HDL_ChartState));
+        ext->chart->min = range[0];
+        ext->chart->max = range[1];
+    }
+
+    // Clip state of a scroll container
+    if(desc->tag == HDL_TAG_SCROLL) {
+        if((ext = _hdl_addExt(interface, el)) == NULL)
+            return HDL_ERR_MEMORY;
+        ext->scroll = HMALLOC(sizeof(struct HDL_ScrollState));
+        if(ext->scroll == NULL)
+            return HDL_ERR_MEMORY;
+        memset(ext->scroll, 0, sizeof(struct HDL_ScrollState));
+    }
+
+    // Drawn text of bound content, changed character cells are redrawn on update
+    ext = _hdl_getExt(interface, el);
+    if(ext != NULL && ext->content != NULL && ext->bind_count > 0) {
+        ext->text = HMALLOC(sizeof(struct HDL_TextCache));
+        if(ext->text == NULL)
+            return HDL_ERR_MEMORY;
+        memset(ext->text, 0, sizeof(struct HDL_TextCache));
+    }
+
+    return 0;
+}
+
+// Parses a single element to desc, children are parsed by the caller. Without exts only the description and
+// layout state are built, the content, bindings and other extensions are added by a later call
+int _hdl_buildElement (struct HDL_Interface *interface, struct HDL_Element *parent, struct HDL_Element *el, struct HDL_ElementDesc *desc,
+                        uint8_t *data, int *pc, uint8_t exts) {
+    struct HDL_ElementExt *ext = NULL;
+    // Start of the element record
+    int start = *pc;
+    // Chart value range
+    int16_t range[2] = {0, 100};
+
+    // Initialize element (zero and set defaults)
+    HDL_InitElement(desc, el);
+    
+    // Tag is the first byte
+    desc->tag = (uint8_t)data[(*pc)];
+    (*pc)++;
+
+    // Set parent
+    desc->parent = parent != NULL ? (uint16_t)(parent - interface->elements) : HDL_NO_ELEMENT;
+    
+    // Set content
+    if(data[*pc] != 0) {
+        int contentLength = strlen((const char*)&data[(*pc)]);
+        if(exts) {
+            if((ext = _hdl_addExt(interface, el)) == NULL)
+                return HDL_ERR_MEMORY;
+            ext->content = _hdl_keep(interface, &data[(*pc)], contentLength + 1);
+            if(ext->content == NULL)
+                return HDL_ERR_MEMORY;
+        }
+
+        (*pc) += contentLength + 1;
+    }
+    else {
+        (*pc)++;
+    }
+
+    // Attribute count
+    uint8_t attrs = (uint8_t)data[(*pc)];
+    (*pc)++;
+
+    for(int a = 0; a < attrs; a++) {
+        enum HDL_AttrIndex attrKey = (enum HDL_AttrIndex)data[(*pc)++];
+        enum HDL_Type attrType = (enum HDL_Type)data[(*pc)++];
+        uint8_t count = data[(*pc)++];
+
+        if(attrType == HDL_TYPE_BIND && attrKey != HDL_ATTR_BIND) {
+            if(!exts) {
+                (*pc) += 2 * count;
+                continue;
+            }
+            if((ext = _hdl_addExt(interface, el)) == NULL)
+                return HDL_ERR_MEMORY;
+
+            if(ext->boundAttrCount >= HDL_CONF_MAX_ATTR_BINDINGS) {
+                // Too many bound attributes, ignored
+                (*pc) += 2 * count;
+                continue;
+            }
+            if(_hdl_grow((void**)&interface->attrBinds, &interface->_attrBindCap, interface->attrBindCount + 1, sizeof(struct HDL_AttrBind)))
+                return HDL_ERR_MEMORY;
+
+            // Bound attributes of an element are contiguous, elements are parsed one at a time
+            struct HDL_AttrBind *battr = &interface->attrBinds[interface->attrBindCount++];
+            ext->boundAttrCount++;
+
+            battr->key = attrKey;
+            battr->count = count;
+            if(count == 1) {
+                battr->bind.value = *(uint16_t*)&data[*pc];
+                (*pc) += 2;
+            }
+            else {
+                battr->bind.values = _hdl_keep(interface, &data[*pc], sizeof(uint16_t) * count);
+                if(battr->bind.values == NULL) {
+                    battr->count = 1;
+                    return HDL_ERR_MEMORY;
+                }
+                (*pc) += 2 * count;
+            }
+
+            continue;
+        }
+
+
+        // Type checks
+        uint8_t typeFail = 0;
+
+        switch(attrKey) {
+            // Numbers
+            // Integers (8bit)
+            case HDL_ATTR_FLEX:
+            case HDL_ATTR_FLEX_DIR:
+            case HDL_ATTR_SIZE:
+            case HDL_ATTR_ALIGN:
+            case HDL_ATTR_VALUE:
+            case HDL_ATTR_BORDER:
+            case HDL_ATTR_RADIUS:
+            case HDL_ATTR_SPRITE:
+            case HDL_ATTR_COLOR:
+            case HDL_ATTR_BACKGROUND:
+            {
+                // Should be single 8-bit integer or binding
+                if(count > 1 || (attrType != HDL_TYPE_I8 && attrType != HDL_TYPE_BIND)) {
+                    // Incorrect value, ignored
+                    typeFail = 1;
+                }
+                break;
+            }
+            // Image/16-bit integer
+            case HDL_ATTR_IMG:
+            case HDL_ATTR_FONT:
+            {
+                // Should be single u16
+                if(count > 1 || (attrType != HDL_TYPE_IMG && attrType != HDL_TYPE_I16)) {
+                    // Incorrect value, ignored
+                    typeFail = 1;
+                }
+                break;
+            }
+            // Boolean
+            case HDL_ATTR_DISABLED:
+            case HDL_ATTR_CACHE:
+            case HDL_ATTR_FILL:
+            {
+                // Boolean
+                if((attrType != HDL_TYPE_BOOL && attrType != HDL_TYPE_BIND)) {
+                    typeFail = 1;
+                }
+                break;
+            }
+            // Integers (8/16bit)
+            case HDL_ATTR_X:
+            case HDL_ATTR_Y:
+            case HDL_ATTR_WIDTH:
+            case HDL_ATTR_HEIGHT:
+            case HDL_ATTR_WIDGET:
+            case HDL_ATTR_SCROLL:
+            {
+                // Should be single 8/16-bit integer
+                if(count > 1 || (attrType != HDL_TYPE_I8 && attrType != HDL_TYPE_I16 && attrType != HDL_TYPE_BIND)) {
+                    // Incorrect value, ignored
+                    typeFail = 1;
+                }
+                break;
+            }
+            // Integers (8/16bit int array)
+            case HDL_ATTR_PADDING:
+            case HDL_ATTR_BIND:
+            case HDL_ATTR_RANGE:
+            {
+                if((attrType != HDL_TYPE_I8 && attrType != HDL_TYPE_I16 && attrType != HDL_TYPE_BIND)) {
+                    // Incorrect value, ignored
+                    typeFail = 1;
+                }
+                break;
+            }
+            // Resolved layout (16bit int array)
+            case HDL_ATTR_STATIC:
+            {
+                if(attrType != HDL_TYPE_I16 || (count != 4 && count != 6)) {
+                    typeFail = 1;
+                }
+                break;
+            }
+        }
+
+        // Save single integer value here
+        int32_t tmpVal = 0;
+        switch(attrType) {
+            case HDL_TYPE_BOOL:
+            case HDL_TYPE_I8:
+            {
+                tmpVal = *(int8_t*)&data[*pc];
+                break;
+            }
+            case HDL_TYPE_IMG:
+            case HDL_TYPE_I16:
+            case HDL_TYPE_BIND:
+            {
+                tmpVal = *(int16_t*)&data[*pc];
+                break;
+            }
+            case HDL_TYPE_I32:
+            {
+                tmpVal = *(int32_t*)&data[*pc];
+                break;
+            }
+            default:
+            {
+                tmpVal = 0;
+                break;
+            }
+        }
+
+        if(!typeFail) {
+            switch(attrKey) {
+                case HDL_ATTR_X:
+                    el->x = tmpVal;
+                    break;
+                case HDL_ATTR_Y:
+                    el->y = tmpVal;
+                    break;
+                case HDL_ATTR_WIDTH:
+                    el->width = tmpVal;
+                    break;
+                case HDL_ATTR_HEIGHT:
+                    el->height = tmpVal;
+                    break;
+                case HDL_ATTR_FLEX:
+                    desc->attrs.flex = tmpVal;
+                    break;
+                case HDL_ATTR_FLEX_DIR:
+                    desc->attrs.flexDir = tmpVal;
+                    break;
+                case HDL_ATTR_BIND:
+                {
+                    if(!exts)
+                        break;
+                    if((ext = _hdl_addExt(interface, el)) == NULL)
+                        return HDL_ERR_MEMORY;
+                    ext->bindings = _hdl_keep(interface, &data[(*pc)], sizeof(uint16_t) * count);
+                    if(ext->bindings == NULL)
+                        return HDL_ERR_MEMORY;
+                    ext->bind_count = count;
+                    break;
+                }
+                case HDL_ATTR_IMG:
+                    desc->attrs.image = tmpVal;
+                    break;
+                case HDL_ATTR_FONT:
+                    desc->attrs.font = tmpVal;
+                    break;
+                case HDL_ATTR_PADDING:
+                {
+                    if(count > 1) {
+                        // Paddings seperately
+                        if(attrType == HDL_TYPE_I8) {
+                            desc->attrs.padding_x = (int8_t)((int8_t*)&data[(*pc)])[0];
+                            desc->attrs.padding_y = (int8_t)((int8_t*)&data[(*pc)])[1];
+                        }
+                        else {
+                            desc->attrs.padding_x = (int16_t)((int16_t*)&data[(*pc)])[0];
+                            desc->attrs.padding_y = (int16_t)((int16_t*)&data[(*pc)])[1];
+                        }
+                    }
+                    else {
+                        // Both paddings from single value
+                        desc->attrs.padding_x = tmpVal;
+                        desc->attrs.padding_y = tmpVal;
+                    }
+                    break;
+                }
+                case HDL_ATTR_ALIGN:
+                    desc->attrs.align = tmpVal;
+                    break;
+                case HDL_ATTR_DISABLED:
+                    el->disabled = tmpVal;
+                    break;
+                case HDL_ATTR_SIZE:
+                    desc->attrs.size = tmpVal;
+                    break;
+                case HDL_ATTR_VALUE:
+                    desc->attrs.value = tmpVal;
+                    break;
+                case HDL_ATTR_SPRITE:
+                    desc->attrs.sprite = tmpVal;
+                    break;
+                case HDL_ATTR_BORDER:
+                    desc->attrs.border = tmpVal;
+                    break;
+                case HDL_ATTR_RADIUS:
+                    desc->attrs.radius = tmpVal;
+                    break;
+                case HDL_ATTR_CACHE:
+                    if(tmpVal)
+                        el->flags |= HDL_FLAG_CACHE;
+                    break;
+                case HDL_ATTR_FILL:
+                    desc->attrs.fill = tmpVal;
+                    break;
+                case HDL_ATTR_COLOR:
+                    desc->attrs.color = tmpVal;
+                    break;
+                case HDL_ATTR_BACKGROUND:
+                    desc->attrs.background = tmpVal;
+                    break;
+                case HDL_ATTR_WIDGET:
+                    desc->attrs.widget = tmpVal;
+                    break;
+                case HDL_ATTR_SCROLL:
+                    desc->attrs.scroll = tmpVal;
+                    break;
+                case HDL_ATTR_RANGE:
+                    if(count == 2) {
+                        for(int x = 0; x < 2; x++) {
+                            range[x] = attrType == HDL_TYPE_I8 ? ((int8_t*)&data[(*pc)])[x] : ((int16_t*)&data[(*pc)])[x];
+                        }
+                    }
+                    break;
+                case HDL_ATTR_STATIC:
+                {
+                    // Ignored if resolved for another screen, the element is laid out as usual
+                    if(!interface->_staticLayout)
+                        break;
+                    int16_t *values = (int16_t*)&data[(*pc)];
+                    el->x = values[0];
+                    el->y = values[1];
+                    el->width = values[2];
+                    el->height = values[3];
+                    el->flags |= HDL_FLAG_STATIC;
+                    if(count == 6 && exts) {
+                        if((ext = _hdl_addExt(interface, el)) == NULL)
+                            return HDL_ERR_MEMORY;
+                        ext->contentX = values[4];
+                        ext->contentY = values[5];
+                        el->flags |= HDL_FLAG_STATIC_CONTENT;
+                    }
+                    break;
+                }
+
+            }
+        }
+        else {
+            //printf("TYPEFAIL: %i = %i at %X\n", attrKey, attrType, (*pc));
+        }
+
+        // Increment pc
+        if(attrType < sizeof(TYPE_SIZES)) {
+            if(attrType == HDL_TYPE_STRING) {
+                while(data[(*pc)++] != 0) {
+                    // Loop until null termination
+                }
+            }
+            else {
+                (*pc) += TYPE_SIZES[attrType] * count;
+            }
+        }
+    }
+
+    if(parent == NULL) {
+        interface->root = el;
+        // Set width and height to maximum if root element
+        if(el->height == 0 && el->width == 0) {
+            el->width = interface->width - 1;
+            el->height = interface->height - 1;
+        }
+    }
+
+    if(exts) {
+        int err = _hdl_buildStates(interface, el, desc, range);
+        if(err)
+            return err;
+    }
+
+#ifdef HDL_CONF_REBUILD
+    // Children are matched separately by HDL_Rebuild
+    if(interface->_elementHash != NULL)
+        interface->_elementHash[el - interface->elements] = _hdl_fnv(HDL_FNV_INIT, &data[start], *pc - start);
+#endif
+
+    // Child count
+    desc->child_count = (uint8_t)data[(*pc)];
+    (*pc)++;
+
+    return 0;
+}
+
+// Returns 1 if the descendants of a switch child can be built on activation.
+// Pages inside lists, cached subtrees and other pages are built with their parent
+int _hdl_isLazyPage (struct HDL_Interface *interface, struct HDL_Element *parent, struct HDL_Element *el) {
+    if(_hdl_desc(interface, parent)->tag != HDL_TAG_SWITCH || _hdl_desc(interface, el)->child_count == 0)
+        return 0;
+
+    for(struct HDL_Element *p = parent; ; p = &interface->elements[_hdl_desc(interface, p)->parent]) {
+        if(_hdl_desc(interface, p)->tag == HDL_TAG_LIST || (p->flags & (HDL_FLAG_PAGE | HDL_FLAG_CACHE)))
+            return 0;
+        if(_hdl_desc(interface, p)->parent == HDL_NO_ELEMENT)
+            return 1;
+    }
+}
+
+// Registers a switch page for HDL_SetPageCache
+int _hdl_addPage (struct HDL_Interface *interface, struct HDL_Element *el, uint32_t offset) {
+    if(_hdl_grow((void**)&interface->_pages, &interface->_pageCap, interface->_pageCount + 1, sizeof(struct HDL_Page)))
+        return HDL_ERR_MEMORY;
+
+    struct HDL_Page *page = &interface->_pages[interface->_pageCount++];
+    page->element = el - interface->elements;
+    page->built = 0;
+    page->bytes = 0;
+    page->offset = offset;
+    page->lastUse = interface->_lastUpdate;
+    el->flags |= HDL_FLAG_PAGE;
+    return 0;
+}
+
+// Resets the state of the descendants of a page that is not built, their descriptions are kept
+void _hdl_clearPage (struct HDL_Interface *interface, uint16_t start, uint16_t end) {
+    for(uint16_t i = start; i < end; i++) {
+        struct HDL_Element *el = &interface->elements[i];
+        memset(el, 0, sizeof(struct HDL_Element));
+        el->ext = HDL_NO_EXT;
+        el->disabled = 1;
+    }
+}
+
+// Build traversal frame
+struct _hdl_BuildFrame {
+    struct HDL_Element *element;
+    // Children parsed
+    uint16_t index;
+    // Last parsed child
+    uint16_t last;
+    // Children get their extensions, not set in inactive pages
+    uint8_t exts;
+};
+
+// Parses the descendants of a built element in pre-order without recursion, from the element stream at pc
+// to the element slots from *elementIndex. With an index, each element is read from its indexed offset.
+// With lazy, switch pages are registered and the descendants of inactive ones are built without extensions
+int _hdl_buildChildren (struct HDL_Interface *interface, uint8_t *data, int *pc, const struct HDL_ElementIndex *index, 
+                        struct HDL_Element *root, int *elementIndex, uint8_t lazy) {
+    struct _hdl_BuildFrame stack[HDL_CONF_MAX_DEPTH];
+    int depth = 0;
+    int err;
+
+    // Depth of the root counts against the render stack
+    int base = 0;
+    for(struct HDL_Element *p = root; _hdl_desc(interface, p)->parent != HDL_NO_ELEMENT; p = &interface->elements[_hdl_desc(interface, p)->parent]) {
+        base++;
+    }
+
+    stack[depth].element = root;
+    stack[depth].index = 0;
+    stack[depth].last = HDL_NO_ELEMENT;
+    stack[depth].exts = 1;
+    depth++;
+
+    while(depth > 0) {
+        struct _hdl_BuildFrame *frame = &stack[depth - 1];
+        struct HDL_Element *parent = frame->element;
+
+        if(frame->index >= _hdl_desc(interface, parent)->child_count) {
+            depth--;
+            continue;
+        }
+
+        if(*elementIndex >= interface->elementCount)
+            return HDL_ERR_PARSE;
+
+        int i = frame->index++;
+        // Elements are in pre-order, link the child after its previous sibling
+        if(frame->last == HDL_NO_ELEMENT) {
+            _hdl_buildDesc(interface, parent)->first_child = *elementIndex;
+        }
+        else {
+            _hdl_buildDesc(interface, &interface->elements[frame->last])->next_sibling = *elementIndex;
+        }
+        frame->last = *elementIndex;
+        if(index != NULL)
+            *pc = index[*elementIndex].offset;
+        struct HDL_Element *el = &interface->elements[(*elementIndex)++];
+
+        if((err = _hdl_buildElement(interface, parent, el, _hdl_buildDesc(interface, el), data, pc, frame->exts)))
+            return err;
+        uint8_t exts = frame->exts;
+
+        if(_hdl_desc(interface, parent)->tag == HDL_TAG_SWITCH) {
+            // Set disabled value according to element's value
+            el->disabled = _hdl_attrs(interface, parent)->value != i;
+        }
+
+        if(lazy && _hdl_isLazyPage(interface, parent, el)) {
+            if((err = _hdl_addPage(interface, el, *pc)))
+                return err;
+
+            // Inactive page, extensions of the descendants are built when it is shown
+            if(el->disabled)
+                exts = 0;
+            else
+                interface->_pages[interface->_pageCount - 1].built = 1;
+        }
+
+        if(_hdl_desc(interface, el)->child_count > 0) {
+            if(base + depth >= HDL_CONF_MAX_DEPTH)
+                return HDL_ERR_DEPTH;
+
+            stack[depth].element = el;
+            stack[depth].index = 0;
+            stack[depth].last = HDL_NO_ELEMENT;
+            stack[depth].exts = exts;
+            depth++;
+        }
+    }
+
+    return 0;
+}
+
+// Builds the element stream at pc. With an index, each element is read from its indexed offset
+int _hdl_buildElements (struct HDL_Interface *interface, uint8_t *data, int *pc, const struct HDL_ElementIndex *index) {
+    int elementIndex = 0;
+
+    if(interface->elementCount == 0)
+        return HDL_ERR_NO_ROOT;
+
+    if(index != NULL)
+        *pc = index[elementIndex].offset;
+    struct HDL_Element *root = &interface->elements[elementIndex++];
+    int err = _hdl_buildElement(interface, NULL, root, _hdl_buildDesc(interface, root), data, pc, 1);
+    if(err)
+        return err;
+
+    return _hdl_buildChildren(interface, data, pc, index, root, &elementIndex, interface->_lazyPages);
+}
+
+int _hdl_buildBitmap (struct HDL_Interface *interface, struct HDL_Bitmap *bmp, uint8_t *data, int *pc) {
+
+    bmp->id = *(uint16_t*)&data[*pc];
+    (*pc) += 2;
+    bmp->size = *(uint16_t*)&data[*pc];
+    (*pc) += 2;
+    bmp->width = *(uint16_t*)&data[*pc];
+    (*pc) += 2;
+    bmp->height = *(uint16_t*)&data[*pc];
+    (*pc) += 2;
+    bmp->sprite_width = *(uint8_t*)&data[*pc];
+    (*pc) += 1;
+    bmp->sprite_height = *(uint8_t*)&data[*pc];
+    (*pc) += 1;
+    bmp->colorMode = data[*pc];
+    (*pc) += 1;
+
+    bmp->_lastUse = 0;
+    if(interface->f_loadBitmap != NULL && !interface->residentDocument) {
+        // Only record where the data is, it is loaded on first draw
+        bmp->data = NULL;
+        bmp->offset = *pc;
+    }
+    else {
+        bmp->offset = 0;
+        bmp->data = (uint8_t*)_hdl_keep(interface, &data[*pc], bmp->size);
+        if(bmp->data == NULL)
+            return HDL_ERR_MEMORY;
+    }
+
+    (*pc) += bmp->size;
+    return 0;
+}
+
+// Reads a preloaded bitmap, the data is kept by reference
+int _hdl_parseBitmap (struct HDL_Bitmap *bmp, uint16_t id, uint8_t *data, int len) {
+    int pc = 0;
+    if(len <= sizeof(struct HDL_Bitmap) + 1) {
+        return HDL_ERR_PARSE;
+    }
+
+    bmp->id = id;
+    pc += 2;
+    bmp->size = *(uint16_t*)&data[pc];
+    pc += 2;
+    bmp->width = *(uint16_t*)&data[pc];
+    pc += 2;
+    bmp->height = *(uint16_t*)&data[pc];
+    pc += 2;
+    bmp->sprite_width = *(uint8_t*)&data[pc];
+    pc += 1;
+    bmp->sprite_height = *(uint8_t*)&data[pc];
+    pc += 1;
+    bmp->colorMode = data[pc];
+    pc += 1;
+
+    bmp->data = &data[pc];
+    bmp->offset = 0;
+    return 0;
+}
+
+// Reads a preloaded font, the data is kept by reference
+int _hdl_parseFont (struct HDL_Bitmap *bmp, uint16_t id, uint8_t *data, int len) {
+    if(len < (int)sizeof(struct HDL_FontHeader) || len > 0xFFFF) {
+        return HDL_ERR_PARSE;
+    }
+
+    memset(bmp, 0, sizeof(struct HDL_Bitmap));
+    bmp->id = id;
+    bmp->size = len;
+    bmp->colorMode = HDL_BITMAP_FONT;
+    bmp->data = data;
+
+    // Referenced data is read without the interface
+    struct _hdl_Font font;
+    if(_hdl_openFont(NULL, bmp, &font)) {
+        bmp->id = 0xFFFF;
+        return HDL_ERR_PARSE;
+    }
+    return 0;
+}
+
+int HDL_PreloadBitmap (struct HDL_Interface *interface, uint16_t id, uint8_t *data, int len) {
+    if(interface->bitmapCount_pl >= HDL_CONF_MAX_PRELOADED_IMAGES) {
+        return HDL_ERR_MEMORY;
+    }
+
+    int err = _hdl_parseBitmap(&interface->bitmaps_pl[interface->bitmapCount_pl], id, data, len);
+    if(err)
+        return err;
+
+    interface->bitmapCount_pl++;
+
+    _hdl_resolveRefs(interface);
+
+    return 0;
+}
+
+int HDL_PreloadFont (struct HDL_Interface *interface, uint16_t id, uint8_t *data, int len) {
+    if(interface->bitmapCount_pl >= HDL_CONF_MAX_PRELOADED_IMAGES) {
+        return HDL_ERR_MEMORY;
+    }
+
+    int err = _hdl_parseFont(&interface->bitmaps_pl[interface->bitmapCount_pl], id, data, len);
+    if(err)
+        return err;
+
+    interface->bitmapCount_pl++;
+
+    _hdl_resolveRefs(interface);
+
+    return 0;
+}
+
+struct HDL_AssetStore HDL_CreateAssetStore (void) {
+    struct HDL_AssetStore store;
+    memset(&store, 0, sizeof(struct HDL_AssetStore));
+    return store;
+}
+
+int HDL_AttachAssets (struct HDL_Interface *interface, struct HDL_AssetStore *store) {
+    if(interface == NULL)
+        return HDL_ERR_NO_ROOT;
+
+    // Kept document data belongs to the attached store
+    if(interface->elements != NULL)
+        return HDL_ERR_IN_USE;
+
+    if(interface->assets != NULL)
+        interface->assets->users--;
+    interface->assets = store;
+    if(store != NULL)
+        store->users++;
+    return 0;
+}
+
+// Adds a parsed bitmap to the store. Bitmaps are allocated one by one as resolved elements point to them
+int _hdl_storeBitmap (struct HDL_AssetStore *store, const struct HDL_Bitmap *parsed) {
+    if(_hdl_grow((void**)&store->bitmaps, &store->_bitmapCap, store->stats.bitmaps + 1, sizeof(struct HDL_Bitmap*)))
+        return HDL_ERR_MEMORY;
+
+    struct HDL_Bitmap *bmp = HMALLOC(sizeof(struct HDL_Bitmap));
+    if(bmp == NULL)
+        return HDL_ERR_MEMORY;
+
+    *bmp = *parsed;
+    store->bitmaps[store->stats.bitmaps++] = bmp;
+    return 0;
+}
+
+int HDL_StoreBitmap (struct HDL_AssetStore *store, uint16_t id, uint8_t *data, int len) {
+    struct HDL_Bitmap bmp;
+    int err = _hdl_parseBitmap(&bmp, id, data, len);
+    if(err)
+        return err;
+    return _hdl_storeBitmap(store, &bmp);
+}
+
+int HDL_StoreFont (struct HDL_AssetStore *store, uint16_t id, uint8_t *data, int len) {
+    struct HDL_Bitmap bmp;
+    int err = _hdl_parseFont(&bmp, id, data, len);
+    if(err)
+        return err;
+    return _hdl_storeBitmap(store, &bmp);
+}
+
+int HDL_FreeAssets (struct HDL_AssetStore *store) {
+    if(store->users > 0)
+        return HDL_ERR_IN_USE;
+
+    for(uint16_t i = 0; i < store->stats.bitmaps; i++) {
+        HFREE(store->bitmaps[i]);
+    }
+    if(store->bitmaps != NULL)
+        HFREE(store->bitmaps);
+
+    // Interned data is released by HDL_Free of the interfaces, the table is empty here
+    if(store->_blobs != NULL)
+        HFREE(store->_blobs);
+
+    memset(store, 0, sizeof(struct HDL_AssetStore));
+    return 0;
+}
+
+void HDL_SetPalette (struct HDL_Interface *interface, const uint8_t *palette, uint16_t count) {
+    if(interface == NULL)
+        return;
+
+    interface->palette = palette;
+    interface->paletteSize = palette != NULL ? count : 0;
+    interface->_color = HDL_COLOR_UNKNOWN;
+
+    // Redraw with the new colors
+    for(uint16_t i = 0; i < interface->elementExtCount; i++) {
+        if(interface->elementExt[i].cache != NULL)
+            interface->elementExt[i].cache->valid = 0;
+    }
+    interface->_pending = 1;
+    interface->_changedSlots = 0xFFFFFFFFUL;
+    _hdl_updateDeadline(interface);
+}
+
+int HDL_AddWidget (struct HDL_Interface *interface, uint16_t id, void (*render)(struct HDL_Interface*, const struct HDL_Element*)) {
+
+    if(interface->widgetCount >= HDL_CONF_MAX_WIDGETS) {
+        return HDL_ERR_MEMORY;
+    }
+    struct HDL_Widget *widget = &interface->widgets[interface->widgetCount++];
+    widget->id = id;
+    widget->widget = render;
+
+    _hdl_resolveRefs(interface);
+
+    return 0;
+}
+
+// Resolves bitmap, sprite and widget of an element
+void _hdl_resolveElement (struct HDL_Interface *interface, struct HDL_Element *element) {
+    struct HDL_ElementExt *ext = _hdl_getExt(interface, element);
+    if(ext == NULL)
+        return;
+
+    ext->bitmap = NULL;
+    ext->widget = NULL;
+    ext->font = NULL;
+    ext->spriteX = 0;
+    ext->spriteY = 0;
+    const struct HDL_Attrs *attrs = _hdl_attrs(interface, element);
+
+    if(attrs->image != 0xFFFF) {
+        ext->bitmap = _hdl_getBitmap(interface, attrs->image);
+    }
+    if(ext->bitmap != NULL && ext->bitmap->width > 0) {
+        struct HDL_Bitmap *bmp = ext->bitmap;
+        uint32_t sprite_xp = (uint32_t)bmp->sprite_width * attrs->sprite;
+        ext->spriteX = sprite_xp % bmp->width;
+        ext->spriteY = (sprite_xp / bmp->width) * bmp->sprite_height;
+    }
+
+    if(attrs->font != 0xFFFF) {
+        ext->font = _hdl_getBitmap(interface, attrs->font);
+        if(ext->font != NULL && (ext->font->colorMode & 0x0F) != HDL_BITMAP_FONT)
+            ext->font = NULL;
+    }
+
+    if(attrs->widget != 0xFFFF) {
+        for(int i = 0; i < interface->widgetCount; i++) {
+            if(interface->widgets[i].id == attrs->widget) {
+                ext->widget = &interface->widgets[i];
+                break;
+            }
+        }
+    }
+}
+
+// Resolves references of all elements, called when bitmap or widget tables change
+void _hdl_resolveRefs (struct HDL_Interface *interface) {
+    if(interface->elements == NULL)
+        return;
+
+    for(int i = 0; i < interface->elementCount; i++) {
+        _hdl_resolveElement(interface, &interface->elements[i]);
+    }
+}
+
+// Returns the bitmap. If not found returns NULL
+struct HDL_Bitmap *_hdl_getBitmap (struct HDL_Interface *interface, uint16_t id) {
+    // Bitmaps from files
+    for(int i = 0; i < interface->bitmapCount; i++) {
+        if(interface->bitmaps[i].id == id) {
+            return &interface->bitmaps[i];
+        }
+    }
+    // Preloaded bitmaps
+    for(int i = 0; i < interface->bitmapCount_pl; i++) {
+        if(interface->bitmaps_pl[i].id == id) {
+            return &interface->bitmaps_pl[i];
+        }
+    }
+    // Shared bitmaps
+    if(interface->assets != NULL) {
+        for(int i = 0; i < interface->assets->stats.bitmaps; i++) {
+            if(interface->assets->bitmaps[i]->id == id) {
+                return interface->assets->bitmaps[i];
+            }
+        }
+    }
+    // Not found
+    return NULL;
+}
+
+// Frees the least recently used lazy bitmap. Returns 0 if nothing could be freed
+int _hdl_evictBitmap (struct HDL_Interface *interface) {
+    struct HDL_Bitmap *lru = NULL;
+    for(int i = 0; i < interface->bitmapCount; i++) {
+        struct HDL_Bitmap *bmp = &interface->bitmaps[i];
+        if(bmp->offset == 0 || bmp->data == NULL)
+            continue;
+        if(lru == NULL || (uint32_t)(interface->_bitmapTick - bmp->_lastUse) > (uint32_t)(interface->_bitmapTick - lru->_lastUse)) {
+            lru = bmp;
+        }
+    }
+    if(lru == NULL)
+        return 0;
+
+    HFREE(lru->data);
+    lru->data = NULL;
+    interface->bitmapStats.used -= lru->size;
+    interface->bitmapStats.evictions++;
+    return 1;
+}
+
+// Returns bitmap data, loading it through f_loadBitmap if needed. NULL if it could not be loaded
+uint8_t *_hdl_getBitmapData (struct HDL_Interface *interface, struct HDL_Bitmap *bmp) {
+    // Resident data
+    if(bmp->offset == 0)
+        return bmp->data;
+
+    bmp->_lastUse = ++interface->_bitmapTick;
+
+    if(bmp->data != NULL) {
+        interface->bitmapStats.hits++;
+        return bmp->data;
+    }
+
+    interface->bitmapStats.misses++;
+
+    if(bmp->size > interface->bitmapBudget || interface->f_loadBitmap == NULL)
+        return NULL;
+
+    // Make room within the budget
+    while(interface->bitmapStats.used + bmp->size > interface->bitmapBudget) {
+        if(!_hdl_evictBitmap(interface))
+            return NULL;
+    }
+
+    bmp->data = HMALLOC(bmp->size);
+    if(bmp->data == NULL)
+        return NULL;
+
+    if(interface->f_loadBitmap(bmp->offset, bmp->data, bmp->size)) {
+        HFREE(bmp->data);
+        bmp->data = NULL;
+        return NULL;
+    }
+
+    interface->bitmapStats.used += bmp->size;
+    return bmp->data;
+}
+
+void HDL_SetBitmapLoader (struct HDL_Interface *interface, int (*loader)(uint32_t offset, uint8_t *buffer, uint16_t size), uint32_t budget) {
+    if(interface == NULL)
+        return;
+
+    interface->f_loadBitmap = loader;
+    interface->bitmapBudget = budget;
+}
+
+void HDL_SetPageCache (struct HDL_Interface *interface, uint32_t idleTime, uint32_t budget) {
+    if(interface == NULL)
+        return;
+
+    interface->_lazyPages = 1;
+    interface->pageIdleTime = idleTime;
+    interface->pageBudget = budget;
+}
+
+void _hdl_freeExt (struct HDL_Interface *interface, struct HDL_ElementExt *ext);
+
+// Frees the extensions and bound attributes of an element range and removes them from their tables.
+// Extensions of a subtree are contiguous as it is built in pre-order
+int _hdl_removeExts (struct HDL_Interface *interface, uint16_t start, uint16_t end) {
+    uint16_t first = HDL_NO_EXT, last = 0, count = 0;
+
+    for(uint16_t i = start; i < end; i++) {
+        uint16_t e = interface->elements[i].ext;
+        if(e == HDL_NO_EXT)
+            continue;
+        if(e < first)
+            first = e;
+        if(e > last)
+            last = e;
+        count++;
+    }
+    if(count == 0)
+        return 0;
+    if(last - first + 1 != count)
+        return HDL_ERR_PARSE;
+
+    // Bound attributes are in extension order
+    uint16_t attrStart = interface->elementExt[first].boundAttrs;
+    uint16_t attrCount = 0;
+    for(uint16_t e = first; e <= last; e++) {
+        struct HDL_ElementExt *ext = &interface->elementExt[e];
+        for(int a = 0; a < ext->boundAttrCount; a++) {
+            struct HDL_AttrBind *battr = &interface->attrBinds[ext->boundAttrs + a];
+            if(battr->count > 1)
+                _hdl_release(interface, battr->bind.values);
+        }
+        attrCount += ext->boundAttrCount;
+        _hdl_freeExt(interface, ext);
+    }
+
+    // Later extensions and bound attributes move down
+    if(attrCount > 0) {
+        memmove(&interface->attrBinds[attrStart], &interface->attrBinds[attrStart + attrCount], 
+                sizeof(struct HDL_AttrBind) * (interface->attrBindCount - attrStart - attrCount));
+        interface->attrBindCount -= attrCount;
+    }
+    memmove(&interface->elementExt[first], &interface->elementExt[last + 1], 
+            sizeof(struct HDL_ElementExt) * (interface->elementExtCount - last - 1));
+    interface->elementExtCount -= count;
+
+    for(uint16_t e = first; e < interface->elementExtCount; e++) {
+        interface->elementExt[e].boundAttrs -= attrCount;
+    }
+    for(uint16_t i = 0; i < interface->elementCount; i++) {
+        struct HDL_Element *element = &interface->elements[i];
+        if(element->ext == HDL_NO_EXT)
+            continue;
+        if(i >= start && i < end)
+            element->ext = HDL_NO_EXT;
+        else if(element->ext > last)
+            element->ext -= count;
+    }
+    return 0;
+}
+
+// Returns the heap bytes held by the descendants of a page. Allocations made while drawing are not counted
+uint32_t _hdl_pageBytes (struct HDL_Interface *interface, struct HDL_Element *element) {
+    uint32_t bytes = 0;
+    uint16_t end = _hdl_subtreeEnd(interface, element);
+
+    for(uint16_t i = element - interface->elements + 1; i < end; i++) {
+        struct HDL_ElementExt *ext = _hdl_getExt(interface, &interface->elements[i]);
+        if(ext == NULL)
+            continue;
+
+        bytes += sizeof(struct HDL_ElementExt) + sizeof(struct HDL_AttrBind) * ext->boundAttrCount;
+        if(ext->attrs != NULL)
+            bytes += sizeof(struct HDL_Attrs);
+        // Document data is copied unless resident
+        if(!interface->residentDocument) {
+            if(ext->content != NULL)
+                bytes += strlen(ext->content) + 1;
+            bytes += sizeof(uint16_t) * ext->bind_count;
+            for(int a = 0; a < ext->boundAttrCount; a++) {
+                struct HDL_AttrBind *battr = &interface->attrBinds[ext->boundAttrs + a];
+                if(battr->count > 1)
+                    bytes += sizeof(uint16_t) * battr->count;
+            }
+        }
+        if(ext->cache != NULL)
+            bytes += sizeof(struct HDL_SurfaceCache);
+        if(ext->text != NULL)
+            bytes += sizeof(struct HDL_TextCache);
+        if(ext->list != NULL)
+            bytes += sizeof(struct HDL_ListState);
+        if(ext->scroll != NULL)
+            bytes += sizeof(struct HDL_ScrollState);
+        if(ext->chart != NULL)
+            bytes += sizeof(struct HDL_ChartState);
+    }
+    return bytes;
+}
+
+// Frees the extensions of the descendants of a page until it is built again
+void _hdl_freePage (struct HDL_Interface *interface, struct HDL_Page *page) {
+    struct HDL_Element *element = &interface->elements[page->element];
+    uint16_t start = page->element + 1;
+    uint16_t end = _hdl_subtreeEnd(interface, element);
+
+    if(_hdl_removeExts(interface, start, end))
+        return;
+    // Inactive pages are not drawn, the hit test grid has none of their elements
+    _hdl_clearPage(interface, start, end);
+
+    if(page->built) {
+        interface->pageStats.used -= page->bytes;
+        interface->pageStats.frees++;
+    }
+    page->built = 0;
+}
+
+// Frees least recently shown inactive pages until reserve more bytes fit in the budget
+void _hdl_fitPages (struct HDL_Interface *interface, uint32_t reserve) {
+    if(interface->pageBudget == 0)
+        return;
+
+    while(interface->pageStats.used + reserve > interface->pageBudget) {
+        struct HDL_Page *lru = NULL;
+        for(int i = 0; i < interface->_pageCount; i++) {
+            struct HDL_Page *page = &interface->_pages[i];
+            if(!page->built || !interface->elements[page->element].disabled)
+                continue;
+            if(lru == NULL || page->lastUse < lru->lastUse)
+                lru = page;
+        }
+        if(lru == NULL)
+            return;
+        _hdl_freePage(interface, lru);
+    }
+}
+
+// Builds the extensions of the descendants of a page from the .hdl. Their descriptions are built by HDL_Build
+int _hdl_buildPage (struct HDL_Interface *interface, struct HDL_Page *page) {
+    struct HDL_Element *element = &interface->elements[page->element];
+    int start = page->element + 1;
+    int end = _hdl_subtreeEnd(interface, element);
+    int pc = page->offset;
+    int err = 0;
+
+    // Descendants follow the page in pre-order, each is parsed again to a copy of its description
+    for(int i = start; i < end; i++) {
+        struct HDL_Element *el = &interface->elements[i];
+        const struct HDL_ElementDesc *desc = _hdl_desc(interface, el);
+        struct HDL_Element *parent = &interface->elements[desc->parent];
+        struct HDL_ElementDesc copy;
+
+        if(interface->_elementIndex != NULL)
+            pc = interface->_elementIndex[i].offset;
+        if((err = _hdl_buildElement(interface, parent, el, &copy, interface->_source, &pc, 1)))
+            break;
+        if(copy.tag != desc->tag || copy.child_count != desc->child_count) {
+            err = HDL_ERR_PARSE;
+            break;
+        }
+
+        if(_hdl_desc(interface, parent)->tag == HDL_TAG_SWITCH) {
+            // Set disabled value according to element's position
+            uint16_t n = 0;
+            for(uint16_t c = _hdl_desc(interface, parent)->first_child; c != i; c = interface->elementDesc[c].next_sibling) {
+                n++;
+            }
+            el->disabled = _hdl_attrs(interface, parent)->value != n;
+        }
+    }
+    if(err) {
+        // Drop the partially built page
+        if(!_hdl_removeExts(interface, start, end))
+            _hdl_clearPage(interface, start, end);
+        return err;
+    }
+
+    for(int i = start; i < end; i++) {
+        _hdl_resolveElement(interface, &interface->elements[i]);
+    }
+
+    page->built = 1;
+    page->bytes = _hdl_pageBytes(interface, element);
+    interface->pageStats.used += page->bytes;
+    interface->pageStats.builds++;
+    return 0;
+}
+
+// Builds a page that is shown, called when its switch is laid out
+void _hdl_showPage (struct HDL_Interface *interface, struct HDL_Element *element) {
+    for(int i = 0; i < interface->_pageCount; i++) {
+        struct HDL_Page *page = &interface->_pages[i];
+        if(page->element != element - interface->elements)
+            continue;
+
+        page->lastUse = interface->_lastUpdate;
+        if(page->built)
+            return;
+
+        // Size of the last build makes room before building
+        _hdl_fitPages(interface, page->bytes);
+        if(_hdl_buildPage(interface, page) == 0)
+            _hdl_fitPages(interface, 0);
+        return;
+    }
+}
+
+// Frees pages that have not been shown for the idle time
+void _hdl_reclaimPages (struct HDL_Interface *interface, uint64_t time) {
+    for(int i = 0; i < interface->_pageCount; i++) {
+        struct HDL_Page *page = &interface->_pages[i];
+        if(!interface->elements[page->element].disabled) {
+            page->lastUse = time;
+            continue;
+        }
+        if(page->built && interface->pageIdleTime != 0 && time - page->lastUse >= interface->pageIdleTime)
+            _hdl_freePage(interface, page);
+    }
+}
+
+// Parts of a .hdl, see _hdl_openDocument
+struct _hdl_Document {
+    // File size
+    uint32_t len;
+    // HDL_FILE_* features and the metrics of a static layout
+    uint8_t features;
+    uint16_t layoutWidth;
+    uint16_t layoutHeight;
+    uint8_t textWidth;
+    uint8_t textHeight;
+
+    uint16_t bitmapCount;
+    // Offset of the first bitmap, bitmaps follow each other
+    uint32_t bitmaps;
+    // Offset of each bitmap, NULL for version 1
+    const uint32_t *bitmapIndex;
+
+    uint16_t elementCount;
+    // Offset of the root element
+    uint32_t elements;
+    // Offset and subtree size of each element, NULL for version 1
+    const struct HDL_ElementIndex *elementIndex;
+};
+
+// Returns the section of a version 2 file, NULL if there is none
+const struct HDL_Section *_hdl_section (const uint8_t *data, uint32_t type) {
+    const struct HDL_HeaderV2 *header = (const struct HDL_HeaderV2*)data;
+    const struct HDL_Section *sections = (const struct HDL_Section*)&data[sizeof(struct HDL_HeaderV2)];
+    for(int i = 0; i < header->sectionCount; i++) {
+        if(sections[i].type == type)
+            return &sections[i];
+    }
+    return NULL;
+}
+
+// Reads the section table of a version 2 file
+int _hdl_openV2 (const uint8_t *data, uint32_t len, struct _hdl_Document *doc) {
+    const struct HDL_HeaderV2 *header = (const struct HDL_HeaderV2*)data;
+    if(len < sizeof(struct HDL_HeaderV2) || header->fileSize > len || 
+        header->fileSize < sizeof(struct HDL_HeaderV2) + header->sectionCount * sizeof(struct HDL_Section))
+        return HDL_ERR_PARSE;
+    len = header->fileSize;
+
+    const struct HDL_Section *sections = (const struct HDL_Section*)&data[sizeof(struct HDL_HeaderV2)];
+    for(int i = 0; i < header->sectionCount; i++) {
+        if((sections[i].offset & 3) || sections[i].offset > len || sections[i].size > len - sections[i].offset)
+            return HDL_ERR_PARSE;
+    }
+
+    doc->len = len;
+    doc->features = header->features;
+    doc->layoutWidth = header->layoutWidth;
+    doc->layoutHeight = header->layoutHeight;
+    doc->textWidth = header->textWidth;
+    doc->textHeight = header->textHeight;
+
+    const struct HDL_Section *bitmaps = _hdl_section(data, HDL_SECTION_BITMAPS);
+    const struct HDL_Section *bitmapIndex = _hdl_section(data, HDL_SECTION_BITMAP_INDEX);
+    const struct HDL_Section *elements = _hdl_section(data, HDL_SECTION_ELEMENTS);
+    const struct HDL_Section *elementIndex = _hdl_section(data, HDL_SECTION_ELEMENT_INDEX);
+
+    if(elements == NULL || elements->count == 0 || elements->count >= HDL_NO_ELEMENT)
+        return HDL_ERR_PARSE;
+    doc->elementCount = elements->count;
+    doc->elements = elements->offset;
+
+    doc->bitmapCount = 0;
+    if(bitmaps != NULL) {
+        if(bitmaps->count > 0xFFFF)
+            return HDL_ERR_PARSE;
+        doc->bitmapCount = bitmaps->count;
+        doc->bitmaps = bitmaps->offset;
+    }
+
+    // Indexed bitmaps and elements must be in their sections
+    if(bitmapIndex != NULL) {
+        if(bitmapIndex->count != doc->bitmapCount || bitmapIndex->size < bitmapIndex->count * sizeof(uint32_t))
+            return HDL_ERR_PARSE;
+        doc->bitmapIndex = (const uint32_t*)&data[bitmapIndex->offset];
+        for(int i = 0; i < doc->bitmapCount; i++) {
+            if(doc->bitmapIndex[i] < bitmaps->offset || doc->bitmapIndex[i] >= bitmaps->offset + bitmaps->size)
+                return HDL_ERR_PARSE;
+        }
+    }
+    if(elementIndex != NULL) {
+        if(elementIndex->count != doc->elementCount || elementIndex->size < elementIndex->count * sizeof(struct HDL_ElementIndex))
+            return HDL_ERR_PARSE;
+        doc->elementIndex = (const struct HDL_ElementIndex*)&data[elementIndex->offset];
+        for(int i = 0; i < doc->elementCount; i++) {
+            if(doc->elementIndex[i].offset < elements->offset || doc->elementIndex[i].offset >= elements->offset + elements->size ||
+                doc->elementIndex[i].descendants >= (uint32_t)(doc->elementCount - i))
+                return HDL_ERR_PARSE;
+        }
+    }
+    return 0;
+}
+
+// Locates the parts of a .hdl by its major version
+int _hdl_openDocument (const uint8_t *data, uint32_t len, struct _hdl_Document *doc) {
+    memset(doc, 0, sizeof(struct _hdl_Document));
+
+    if(len < sizeof(struct HDL_Header)) {
+        // File too short
+        return HDL_ERR_PARSE;
+    }
+    // Header should be at the start
+    const struct HDL_Header *header = (const struct HDL_Header*)data;
+
+    if(header->majorVersion == 2)
+        return _hdl_openV2(data, len, doc);
+    if(header->majorVersion > 2)
+        return HDL_ERR_VERSION;
+
+    doc->len = len;
+    doc->features = header->features;
+    doc->layoutWidth = header->layoutWidth;
+    doc->layoutHeight = header->layoutHeight;
+    doc->textWidth = header->textWidth;
+    doc->textHeight = header->textHeight;
+    doc->bitmapCount = header->bitmapCount;
+    // Start point just after header
+    doc->bitmaps = sizeof(struct HDL_Header);
+    doc->elementCount = header->elementCount;
+    return 0;
+}
+
+int HDL_Build (struct HDL_Interface *interface, uint8_t *data, uint32_t len) {
+    struct _hdl_Document doc;
+    int err = _hdl_openDocument(data, len, &doc);
+    if(err)
+        return err;
+
+    int pc = doc.bitmaps;
+
+    // Static layout is only used on the screen it was resolved for
+    interface->_staticLayout = (doc.features & HDL_FILE_STATIC_LAYOUT) && doc.layoutWidth == interface->width && 
+        doc.layoutHeight == interface->height && doc.textWidth == interface->textWidth && doc.textHeight == interface->textHeight;
+
+    // Allocate bitmaps
+    interface->bitmapCount = doc.bitmapCount;
+    interface->bitmaps = (struct HDL_Bitmap*)HMALLOC(sizeof(struct HDL_Bitmap) * interface->bitmapCount);
+
+    if(interface->bitmaps == NULL && interface->bitmapCount > 0)
+        return HDL_ERR_MEMORY;
+
+    // Zeroed so a failed build can still be freed
+    if(interface->bitmaps != NULL)
+        memset(interface->bitmaps, 0, sizeof(struct HDL_Bitmap) * interface->bitmapCount);
+
+    // Widgets
+    interface->widgetCount = 0;
+    for(int i = 0; i < HDL_CONF_MAX_WIDGETS; i++) {
+        interface->widgets[i].id = 0xFFFF;
+        interface->widgets[i].widget = NULL;
+    }
+
+    // Allocate vartable TODO:
+
+    // Allocate elements
+    interface->elementCount = doc.elementCount;
+    interface->elements = (struct HDL_Element*)HMALLOC(sizeof(struct HDL_Element) * interface->elementCount);
+
+    if(interface->elements == NULL)
+        return HDL_ERR_MEMORY;
+    interface->elementDesc = (struct HDL_ElementDesc*)HMALLOC(sizeof(struct HDL_ElementDesc) * interface->elementCount);
+    if(interface->elementDesc == NULL)
+        return HDL_ERR_MEMORY;
+
+    // Zeroed so a failed build can still be freed
+    memset(interface->elements, 0, sizeof(struct HDL_Element) * interface->elementCount);
+    memset((void*)interface->elementDesc, 0, sizeof(struct HDL_ElementDesc) * interface->elementCount);
+
+#ifdef HDL_CONF_REBUILD
+    interface->_elementHash = (uint32_t*)HMALLOC(sizeof(uint32_t) * interface->elementCount);
+    if(interface->_elementHash == NULL)
+        return HDL_ERR_MEMORY;
+    interface->_bitmapHash = HDL_FNV_INIT;
+#endif
+
+    for(int i = 0; i < interface->bitmapCount; i++) {
+        if(doc.bitmapIndex != NULL)
+            pc = doc.bitmapIndex[i];
+#ifdef HDL_CONF_REBUILD
+        int start = pc;
+#endif
+        if((err = _hdl_buildBitmap(interface, &interface->bitmaps[i], data, &pc))) {
+
+            return err;
+        }
+#ifdef HDL_CONF_REBUILD
+        interface->_bitmapHash = _hdl_fnv(interface->_bitmapHash, &data[start], pc - start);
+#endif
+    }
+
+    // Start parsing elements, they follow the bitmaps in version 1
+    if(doc.elements != 0)
+        pc = doc.elements;
+    err = _hdl_buildElements(interface, data, &pc, doc.elementIndex);
+
+    if(err) {
+        // Do not render a partially built tree
+        interface->root = NULL;
+        return err;
+    }
+
+    interface->_sourceHash = HDL_SourceHash(data, len);
+
+    _hdl_resolveRefs(interface);
+
+    // Pages are built from the .hdl when shown
+    interface->_source = data;
+    interface->_elementIndex = doc.elementIndex;
+    for(int i = 0; i < interface->_pageCount; i++) {
+        struct HDL_Page *page = &interface->_pages[i];
+        if(page->built) {
+            page->bytes = _hdl_pageBytes(interface, &interface->elements[page->element]);
+            interface->pageStats.used += page->bytes;
+        }
+        else {
+            _hdl_clearPage(interface, page->element + 1, _hdl_subtreeEnd(interface, &interface->elements[page->element]));
+        }
+    }
+
+    return err;
+}
+
+uint32_t HDL_SourceHash (const uint8_t *data, uint32_t len) {
+    return _hdl_fnv(HDL_FNV_INIT, data, len);
+}
+
+// Built state image, see HDL_Serialize. Sections follow the header in order:
+// descriptions, elements, element extensions, bound attributes, bitmaps and record hashes
+#define HDL_IMAGE_MAGIC     0x494C4448UL
+#define HDL_IMAGE_VERSION   5
+
+struct __attribute__((packed)) _hdl_ImageHeader {
+    uint32_t magic;
+    uint8_t version;
+    // Element state and description sizes, images are only valid for the same configuration
+    uint8_t elementSize;
+    uint8_t descSize;
+    uint16_t elementCount;
+    uint16_t extCount;
+    uint16_t attrBindCount;
+    uint16_t bitmapCount;
+    uint32_t sourceHash;
+    // Image size
+    uint32_t size;
+    // Record hashes of HDL_Rebuild follow the bitmaps
+    uint8_t hashes;
+    uint32_t bitmapHash;
+    uint8_t staticLayout;
+};
+
+// Runtime state allocated for an element extension
+#define HDL_IMAGE_CACHE     0x01
+#define HDL_IMAGE_TEXT      0x02
+#define HDL_IMAGE_LIST      0x04
+#define HDL_IMAGE_SCROLL    0x08
+#define HDL_IMAGE_CHART     0x10
+
+// Element extension, followed by the content with terminator and the bindings
+struct __attribute__((packed)) _hdl_ImageExt {
+    // Content length, 0xFFFF if none
+    uint16_t contentLength;
+    uint16_t boundAttrs;
+    uint8_t boundAttrCount;
+    uint8_t bind_count;
+    // HDL_IMAGE_* states
+    uint8_t states;
+    // Chart value range
+    int16_t min;
+    int16_t max;
+    // Static content position
+    int16_t contentX;
+    int16_t contentY;
+};
+
+// Bitmap descriptor, followed by the data if it is not loaded lazily
+struct __attribute__((packed)) _hdl_ImageBitmap {
+    uint16_t id;
+    uint16_t size;
+    uint16_t width;
+    uint16_t height;
+    uint8_t sprite_width;
+    uint8_t sprite_height;
+    uint8_t colorMode;
+    // Offset in the .hdl of a lazily loaded bitmap, 0 if the data follows
+    uint32_t offset;
+};
+
+// Image cursor. Writes past size are only counted
+struct _hdl_Image {
+    uint8_t *data;
+    uint32_t size;
+    uint32_t pc;
+};
+
+void _hdl_imagePut (struct _hdl_Image *image, const void *src, uint32_t len) {
+    if(image->data != NULL && image->pc + len <= image->size)
+        memcpy(&image->data[image->pc], src, len);
+    image->pc += len;
+}
+
+int _hdl_imageGet (const uint8_t *image, uint32_t len, uint32_t *pc, void *dst, uint32_t count) {
+    if(*pc + count > len)
+        return HDL_ERR_PARSE;
+    memcpy(dst, &image[*pc], count);
+    (*pc) += count;
+    return 0;
+}
+
+int32_t HDL_Serialize (struct HDL_Interface *interface, uint8_t *buffer, uint32_t size) {
+    if(interface == NULL || interface->root == NULL)
+        return -HDL_ERR_NO_ROOT;
+
+    // Pages that are not built have no state to write
+    for(int i = 0; i < interface->_pageCount; i++) {
+        if(!interface->_pages[i].built)
+            return -HDL_ERR_PARSE;
+    }
+
+    struct _hdl_Image image = { buffer, size, 0 };
+
+    struct _hdl_ImageHeader header;
+    header.magic = HDL_IMAGE_MAGIC;
+    header.version = HDL_IMAGE_VERSION;
+    header.elementSize = sizeof(struct HDL_Element);
+    header.descSize = sizeof(struct HDL_ElementDesc);
+    header.elementCount = interface->elementCount;
+    header.extCount = interface->elementExtCount;
+    header.attrBindCount = interface->attrBindCount;
+    header.bitmapCount = interface->bitmapCount;
+    header.sourceHash = interface->_sourceHash;
+    header.size = 0;
+    header.hashes = interface->_elementHash != NULL;
+    header.bitmapHash = interface->_bitmapHash;
+    header.staticLayout = interface->_staticLayout;
+    _hdl_imagePut(&image, &header, sizeof(header));
+
+    // Descriptions, aligned so a resident image can be used in place
+    while(image.pc % __alignof__(struct HDL_ElementDesc)) {
+        _hdl_imagePut(&image, "", 1);
+    }
+    _hdl_imagePut(&image, interface->elementDesc, sizeof(struct HDL_ElementDesc) * interface->elementCount);
+
+    // Elements, as not drawn yet
+    for(int i = 0; i < interface->elementCount; i++) {
+        struct HDL_Element el = interface->elements[i];
+        el.flags &= ~HDL_FLAG_VISIBLE;
+        _hdl_imagePut(&image, &el, sizeof(el));
+    }
+
+    for(int i = 0; i < interface->elementExtCount; i++) {
+        struct HDL_ElementExt *ext = &interface->elementExt[i];
+        struct _hdl_ImageExt rec;
+        rec.contentLength = ext->content != NULL ? strlen(ext->content) : 0xFFFF;
+        rec.boundAttrs = ext->boundAttrs;
+        rec.boundAttrCount = ext->boundAttrCount;
+        rec.bind_count = ext->bindings != NULL ? ext->bind_count : 0;
+        rec.states = (ext->cache != NULL ? HDL_IMAGE_CACHE : 0)
+                   | (ext->text != NULL ? HDL_IMAGE_TEXT : 0)
+                   | (ext->list != NULL ? HDL_IMAGE_LIST : 0)
+                   | (ext->scroll != NULL ? HDL_IMAGE_SCROLL : 0)
+                   | (ext->chart != NULL ? HDL_IMAGE_CHART : 0);
+        rec.min = ext->chart != NULL ? ext->chart->min : 0;
+        rec.max = ext->chart != NULL ? ext->chart->max : 0;
+        rec.contentX = ext->contentX;
+        rec.contentY = ext->contentY;
+        _hdl_imagePut(&image, &rec, sizeof(rec));
+
+        if(ext->content != NULL)
+            _hdl_imagePut(&image, ext->content, rec.contentLength + 1);
+        if(rec.bind_count > 0)
+            _hdl_imagePut(&image, ext->bindings, sizeof(uint16_t) * rec.bind_count);
+    }
+
+    for(int i = 0; i < interface->attrBindCount; i++) {
+        struct HDL_AttrBind *battr = &interface->attrBinds[i];
+        _hdl_imagePut(&image, &battr->key, 1);
+        _hdl_imagePut(&image, &battr->count, 1);
+        if(battr->count == 1)
+            _hdl_imagePut(&image, &battr->bind.value, sizeof(uint16_t));
+        else
+            _hdl_imagePut(&image, battr->bind.values, sizeof(uint16_t) * battr->count);
+    }
+
+    for(int i = 0; i < interface->bitmapCount; i++) {
+        struct HDL_Bitmap *bmp = &interface->bitmaps[i];
+        struct _hdl_ImageBitmap rec;
+        rec.id = bmp->id;
+        rec.size = bmp->size;
+        rec.width = bmp->width;
+        rec.height = bmp->height;
+        rec.sprite_width = bmp->sprite_width;
+        rec.sprite_height = bmp->sprite_height;
+        rec.colorMode = bmp->colorMode;
+        rec.offset = bmp->offset;
+        _hdl_imagePut(&image, &rec, sizeof(rec));
+        // Lazily loaded data stays in the .hdl
+        if(bmp->offset == 0)
+            _hdl_imagePut(&image, bmp->data, bmp->size);
+    }
+
+    // HDL_Rebuild after HDL_Restore keeps unchanged elements
+    if(header.hashes)
+        _hdl_imagePut(&image, interface->_elementHash, sizeof(uint32_t) * interface->elementCount);
+
+    if(image.pc <= size && buffer != NULL) {
+        header.size = image.pc;
+        memcpy(buffer, &header, sizeof(header));
+    }
+
+    return image.pc;
+}
+
+// Restores the runtime states of an element extension
+int _hdl_restoreStates (struct HDL_ElementExt *ext, const struct _hdl_ImageExt *rec) {
+    if(rec->states & HDL_IMAGE_CACHE) {
+        if((ext->cache = HMALLOC(sizeof(struct HDL_SurfaceCache))) == NULL)
+            return HDL_ERR_MEMORY;
+        memset(ext->cache, 0, sizeof(struct HDL_SurfaceCache));
+        ext->cache->surface = -1;
+    }
+    if(rec->states & HDL_IMAGE_TEXT) {
+        if((ext->text = HMALLOC(sizeof(struct HDL_TextCache))) == NULL)
+            return HDL_ERR_MEMORY;
+        memset(ext->text, 0, sizeof(struct HDL_TextCache));
+    }
+    if(rec->states & HDL_IMAGE_LIST) {
+        if((ext->list = HMALLOC(sizeof(struct HDL_ListState))) == NULL)
+            return HDL_ERR_MEMORY;
+        memset(ext->list, 0, sizeof(struct HDL_ListState));
+    }
+    if(rec->states & HDL_IMAGE_SCROLL) {
+        if((ext->scroll = HMALLOC(sizeof(struct HDL_ScrollState))) == NULL)
+            return HDL_ERR_MEMORY;
+        memset(ext->scroll, 0, sizeof(struct HDL_ScrollState));
+    }
+    if(rec->states & HDL_IMAGE_CHART) {
+        if((ext->chart = HMALLOC(sizeof(struct HDL_ChartState))) == NULL)
+            return HDL_ERR_MEMORY;
+        memset(ext->chart, 0, sizeof(struct HDL_ChartState));
+        ext->chart->min = rec->min;
+        ext->chart->max = rec->max;
+    }
+    return 0;
+}
+
+// Returns HDL_ERR_PARSE if the descriptions are not a tree in pre-order. Subtrees are walked by index,
+// so every link must point forward and stay inside the parent subtree
+int _hdl_checkTree (struct HDL_Interface *interface) {
+    uint16_t count = interface->elementCount;
+    for(uint16_t i = 0; i < count; i++) {
+        const struct HDL_ElementDesc *desc = &interface->elementDesc[i];
+        // Root first, parents before children
+        if(i == 0 ? (desc->parent != HDL_NO_ELEMENT || desc->next_sibling != HDL_NO_ELEMENT) : desc->parent >= i)
+            return HDL_ERR_PARSE;
+        // The first child directly follows its parent
+        uint8_t childNext = i + 1 < count && interface->elementDesc[i + 1].parent == i;
+        if(desc->first_child != (childNext ? i + 1 : HDL_NO_ELEMENT))
+            return HDL_ERR_PARSE;
+        if(i == 0)
+            continue;
+        // Siblings follow the subtree and end with the parent subtree, checked parents are walked
+        if(desc->next_sibling != HDL_NO_ELEMENT && (desc->next_sibling <= i
+            || desc->next_sibling >= _hdl_subtreeEnd(interface, &interface->elements[desc->parent])
+            || interface->elementDesc[desc->next_sibling].parent != desc->parent))
+            return HDL_ERR_PARSE;
+        // A leaf subtree is the leaf itself
+        if(!childNext && _hdl_subtreeEnd(interface, &interface->elements[i]) != i + 1)
+            return HDL_ERR_PARSE;
+    }
+    return 0;
+}
+
+int HDL_Restore (struct HDL_Interface *interface, const uint8_t *image, uint32_t len, uint32_t sourceHash) {
+    struct _hdl_ImageHeader header;
+    uint32_t pc = 0;
+
+    if(_hdl_imageGet(image, len, &pc, &header, sizeof(header)))
+        return HDL_ERR_PARSE;
+    if(header.magic != HDL_IMAGE_MAGIC || header.version != HDL_IMAGE_VERSION
+        || header.elementSize != sizeof(struct HDL_Element) || header.descSize != sizeof(struct HDL_ElementDesc)
+        || header.sourceHash != sourceHash)
+        return HDL_ERR_VERSION;
+    if(header.size > len || header.elementCount == 0)
+        return HDL_ERR_PARSE;
+    len = header.size;
+
+    // Widgets
+    interface->widgetCount = 0;
+    for(int i = 0; i < HDL_CONF_MAX_WIDGETS; i++) {
+        interface->widgets[i].id = 0xFFFF;
+        interface->widgets[i].widget = NULL;
+    }
+
+    // Descriptions, referenced in place if resident
+    pc += (__alignof__(struct HDL_ElementDesc) - pc % __alignof__(struct HDL_ElementDesc)) % __alignof__(struct HDL_ElementDesc);
+    uint32_t descBytes = sizeof(struct HDL_ElementDesc) * header.elementCount;
+    if(pc + descBytes > len)
+        return HDL_ERR_PARSE;
+    if(interface->residentDocument && ((uintptr_t)&image[pc] % __alignof__(struct HDL_ElementDesc)) != 0)
+        return HDL_ERR_PARSE;
+    if((interface->elementDesc = _hdl_keep(interface, &image[pc], descBytes)) == NULL)
+        return HDL_ERR_MEMORY;
+    interface->_descImage = 1;
+    pc += descBytes;
+
+    // Elements
+    interface->elementCount = header.elementCount;
+    interface->elements = (struct HDL_Element*)HMALLOC(sizeof(struct HDL_Element) * interface->elementCount);
+    if(interface->elements == NULL)
+        return HDL_ERR_MEMORY;
+    if(_hdl_imageGet(image, len, &pc, interface->elements, sizeof(struct HDL_Element) * interface->elementCount))
+        return HDL_ERR_PARSE;
+
+    // Element extensions, counted as they are restored so a failed restore can still be freed
+    if(_hdl_grow((void**)&interface->elementExt, &interface->_elementExtCap, header.extCount, sizeof(struct HDL_ElementExt)))
+        return HDL_ERR_MEMORY;
+    for(int i = 0; i < header.extCount; i++) {
+        struct HDL_ElementExt *ext = &interface->elementExt[interface->elementExtCount++];
+        memset(ext, 0, sizeof(struct HDL_ElementExt));
+
+        struct _hdl_ImageExt rec;
+        if(_hdl_imageGet(image, len, &pc, &rec, sizeof(rec)))
+            return HDL_ERR_PARSE;
+        ext->boundAttrs = rec.boundAttrs;
+        ext->boundAttrCount = rec.boundAttrCount;
+        ext->contentX = rec.contentX;
+        ext->contentY = rec.contentY;
+
+        if(rec.contentLength != 0xFFFF) {
+            if(pc + rec.contentLength + 1 > len || image[pc + rec.contentLength] != 0)
+                return HDL_ERR_PARSE;
+            if((ext->content = _hdl_keep(interface, &image[pc], rec.contentLength + 1)) == NULL)
+                return HDL_ERR_MEMORY;
+            pc += rec.contentLength + 1;
+        }
+        if(rec.bind_count > 0) {
+            if(pc + sizeof(uint16_t) * rec.bind_count > len)
+                return HDL_ERR_PARSE;
+            if((ext->bindings = _hdl_keep(interface, &image[pc], sizeof(uint16_t) * rec.bind_count)) == NULL)
+                return HDL_ERR_MEMORY;
+            pc += sizeof(uint16_t) * rec.bind_count;
+            ext->bind_count = rec.bind_count;
+        }
+
+        int err = _hdl_restoreStates(ext, &rec);
+        if(err)
+            return err;
+    }
+
+    // Bound attributes
+    if(_hdl_grow((void**)&interface->attrBinds, &interface->_attrBindCap, header.attrBindCount, sizeof(struct HDL_AttrBind)))
+        return HDL_ERR_MEMORY;
+    for(int i = 0; i < header.attrBindCount; i++) {
+        struct HDL_AttrBind *battr = &interface->attrBinds[interface->attrBindCount];
+        uint8_t rec[2];
+        if(_hdl_imageGet(image, len, &pc, rec, 2))
+            return HDL_ERR_PARSE;
+        battr->key = rec[0];
+        battr->count = rec[1];
+        if(battr->count == 1) {
+            if(_hdl_imageGet(image, len, &pc, &battr->bind.value, sizeof(uint16_t)))
+                return HDL_ERR_PARSE;
+        }
+        else {
+            if(pc + sizeof(uint16_t) * battr->count > len)
+                return HDL_ERR_PARSE;
+            battr->bind.values = _hdl_keep(interface, &image[pc], sizeof(uint16_t) * battr->count);
+            if(battr->bind.values == NULL)
+                return HDL_ERR_MEMORY;
+            pc += sizeof(uint16_t) * battr->count;
+        }
+        interface->attrBindCount++;
+    }
+
+    // Bitmaps, zeroed so a failed restore can still be freed
+    interface->bitmapCount = header.bitmapCount;
+    interface->bitmaps = (struct HDL_Bitmap*)HMALLOC(sizeof(struct HDL_Bitmap) * interface->bitmapCount);
+    if(interface->bitmaps == NULL && interface->bitmapCount > 0)
+        return HDL_ERR_MEMORY;
+    if(interface->bitmaps != NULL)
+        memset(interface->bitmaps, 0, sizeof(struct HDL_Bitmap) * interface->bitmapCount);
+
+    for(int i = 0; i < interface->bitmapCount; i++) {
+        struct HDL_Bitmap *bmp = &interface->bitmaps[i];
+        struct _hdl_ImageBitmap rec;
+        if(_hdl_imageGet(image, len, &pc, &rec, sizeof(rec)))
+            return HDL_ERR_PARSE;
+        bmp->id = rec.id;
+        bmp->size = rec.size;
+        bmp->width = rec.width;
+        bmp->height = rec.height;
+        bmp->sprite_width = rec.sprite_width;
+        bmp->sprite_height = rec.sprite_height;
+        bmp->colorMode = rec.colorMode;
+        bmp->offset = rec.offset;
+
+        if(rec.offset != 0) {
+            // Loaded on first draw
+            if(interface->f_loadBitmap == NULL)
+                return HDL_ERR_VERSION;
+            continue;
+        }
+        if(pc + bmp->size > len)
+            return HDL_ERR_PARSE;
+        if((bmp->data = (uint8_t*)_hdl_keep(interface, &image[pc], bmp->size)) == NULL)
+            return HDL_ERR_MEMORY;
+        pc += bmp->size;
+    }
+
+    // Record hashes, skipped without HDL_CONF_REBUILD
+#ifdef HDL_CONF_REBUILD
+    if(header.hashes) {
+        interface->_elementHash = (uint32_t*)HMALLOC(sizeof(uint32_t) * interface->elementCount);
+        if(interface->_elementHash == NULL)
+            return HDL_ERR_MEMORY;
+        if(_hdl_imageGet(image, len, &pc, interface->_elementHash, sizeof(uint32_t) * interface->elementCount))
+            return HDL_ERR_PARSE;
+        interface->_bitmapHash = header.bitmapHash;
+    }
+#endif
+    interface->_staticLayout = header.staticLayout;
+
+    // Indices of a damaged image would be followed blindly when rendering
+    if(_hdl_checkTree(interface))
+        return HDL_ERR_PARSE;
+    for(int i = 0; i < interface->elementCount; i++) {
+        if(interface->elements[i].ext != HDL_NO_EXT && interface->elements[i].ext >= interface->elementExtCount)
+            return HDL_ERR_PARSE;
+    }
+    for(int i = 0; i < interface->elementExtCount; i++) {
+        struct HDL_ElementExt *ext = &interface->elementExt[i];
+        if(ext->boundAttrs + ext->boundAttrCount > interface->attrBindCount)
+            return HDL_ERR_PARSE;
+    }
+
+    // Bound values are applied to a copy of the attributes
+    for(int i = 0; i < interface->elementCount; i++) {
+        const struct HDL_ElementDesc *desc = &interface->elementDesc[i];
+        struct HDL_ElementExt *ext = _hdl_getExt(interface, &interface->elements[i]);
+        if(ext == NULL)
+            continue;
+        if(ext->boundAttrCount == 0 || ext->attrs != NULL)
+            continue;
+        if((ext->attrs = HMALLOC(sizeof(struct HDL_Attrs))) == NULL)
+            return HDL_ERR_MEMORY;
+        memcpy(ext->attrs, &desc->attrs, sizeof(struct HDL_Attrs));
+    }
+
+    // Root is the first element in pre-order
+    interface->root = &interface->elements[0];
+    interface->_sourceHash = sourceHash;
+
+    _hdl_resolveRefs(interface);
+
+    return 0;
+}
+
+// Returns 1 if an attribute in mask, bit (1 << key), is bound
+int _hdl_hasBound (struct HDL_Interface *interface, struct HDL_Element *element, uint32_t mask) {
+    struct HDL_ElementExt *ext = _hdl_getExt(interface, element);
+    if(ext == NULL)
+        return 0;
+
+    for(int i = 0; i < ext->boundAttrCount; i++) {
+        if(mask & (1UL << interface->attrBinds[ext->boundAttrs + i].key))
+            return 1;
+    }
+    return 0;
+}
+
+#define HDL_BOUNDS_MASK ((1UL << HDL_ATTR_X) | (1UL << HDL_ATTR_Y) | (1UL << HDL_ATTR_WIDTH) | (1UL << HDL_ATTR_HEIGHT))
+
+// Returns 1 if the children of an element are always laid out the same, given its bounds
+int _hdl_staticChildren (struct HDL_Interface *interface, struct HDL_Element *element) {
+    if(_hdl_desc(interface, element)->tag == HDL_TAG_SWITCH || _hdl_desc(interface, element)->tag == HDL_TAG_LIST || _hdl_desc(interface, element)->tag == HDL_TAG_SCROLL)
+        return 0;
+    if(_hdl_hasBound(interface, element, 1UL << HDL_ATTR_FLEX_DIR))
+        return 0;
+
+    for(uint16_t c = _hdl_desc(interface, element)->first_child; c != HDL_NO_ELEMENT; c = interface->elementDesc[c].next_sibling) {
+        // Bound bounds are applied after layout, flex and disabled change the flex total
+        if(_hdl_hasBound(interface, &interface->elements[c], HDL_BOUNDS_MASK | (1UL << HDL_ATTR_FLEX) | (1UL << HDL_ATTR_DISABLED)))
+            return 0;
+    }
+    return 1;
+}
+
+// Returns 1 if the bounds of an element never change
+int _hdl_isStatic (struct HDL_Interface *interface, struct HDL_Element *element) {
+    while(_hdl_desc(interface, element)->parent != HDL_NO_ELEMENT) {
+        struct HDL_Element *parent = &interface->elements[_hdl_desc(interface, element)->parent];
+        if(!_hdl_staticChildren(interface, parent))
+            return 0;
+        element = parent;
+    }
+    // Root bounds are not laid out
+    return !_hdl_hasBound(interface, element, HDL_BOUNDS_MASK);
+}
+
+// Returns 1 if the bitmap is from the .hdl, preloaded ones may differ on the device
+int _hdl_inFile (struct HDL_Interface *interface, struct HDL_Bitmap *bmp) {
+    return bmp != NULL && bmp >= interface->bitmaps && bmp < interface->bitmaps + interface->bitmapCount;
+}
+
+// Returns 1 if the content of a static element is always at the same position
+int _hdl_isStaticContent (struct HDL_Interface *interface, struct HDL_Element *element, struct HDL_ElementExt *ext) {
+    if(ext == NULL || (ext->content == NULL && ext->bitmap == NULL))
+        return 0;
+    if(ext->content != NULL && ext->bind_count > 0)
+        return 0;
+    if(_hdl_hasBound(interface, element, (1UL << HDL_ATTR_IMG) | (1UL << HDL_ATTR_SIZE) | (1UL << HDL_ATTR_ALIGN) | (1UL << HDL_ATTR_PADDING) | (1UL << HDL_ATTR_FONT)))
+        return 0;
+    if(_hdl_desc(interface, element)->parent != HDL_NO_ELEMENT && _hdl_hasBound(interface, &interface->elements[_hdl_desc(interface, element)->parent], 1UL << HDL_ATTR_PADDING))
+        return 0;
+    if(_hdl_attrs(interface, element)->font != 0xFFFF && !_hdl_inFile(interface, ext->font))
+        return 0;
+    if(_hdl_attrs(interface, element)->image != 0xFFFF && !_hdl_inFile(interface, ext->bitmap))
+        return 0;
+    return 1;
+}
+
+int32_t HDL_Precompile (struct HDL_Interface *interface, const uint8_t *data, uint32_t len, uint8_t *buffer, uint32_t size) {
+    if(interface == NULL || interface->root == NULL)
+        return -HDL_ERR_NO_ROOT;
+    if(len < sizeof(struct HDL_Header))
+        return -HDL_ERR_PARSE;
+
+    const struct HDL_Header *source = (const struct HDL_Header*)data;
+    // The output keeps the version 1 layout of the input
+    if(source->majorVersion != 1)
+        return -HDL_ERR_VERSION;
+    if(source->elementCount != interface->elementCount || source->bitmapCount != interface->bitmapCount)
+        return -HDL_ERR_PARSE;
+
+    // Lay out static children, parents are laid out first in pre-order
+    for(int i = 0; i < interface->elementCount; i++) {
+        struct HDL_Element *element = &interface->elements[i];
+        if(_hdl_desc(interface, element)->first_child == HDL_NO_ELEMENT || !_hdl_staticChildren(interface, element) || !_hdl_isStatic(interface, element))
+            continue;
+
+        struct _hdl_RenderFrame frame;
+        frame.element = element;
+        _hdl_layoutChildren(interface, &frame);
+        while(_hdl_nextChild(interface, &frame) != NULL) {
+            // Children are placed by the frame
+        }
+    }
+
+    struct _hdl_Image image = { buffer, size, 0 };
+
+    struct HDL_Header header = *source;
+    // Format revision with features
+    if(header.minorVersion < 1)
+        header.minorVersion = 1;
+    header.features |= HDL_FILE_STATIC_LAYOUT;
+    header.layoutWidth = interface->width;
+    header.layoutHeight = interface->height;
+    header.textWidth = interface->textWidth;
+    header.textHeight = interface->textHeight;
+    _hdl_imagePut(&image, &header, sizeof(header));
+
+    // Bitmaps are copied as they are
+    uint32_t pc = sizeof(struct HDL_Header);
+    for(int i = 0; i < source->bitmapCount; i++) {
+        if(pc + 11 > len)
+            return -HDL_ERR_PARSE;
+        pc += 11 + *(uint16_t*)&data[pc + 2];
+    }
+    if(pc > len)
+        return -HDL_ERR_PARSE;
+    _hdl_imagePut(&image, &data[sizeof(struct HDL_Header)], pc - sizeof(struct HDL_Header));
+
+    // Elements are in the same order as in HDL_Interface.elements
+    for(int i = 0; i < interface->elementCount; i++) {
+        struct HDL_Element *el = &interface->elements[i];
+        uint8_t isStatic = _hdl_isStatic(interface, el);
+
+        // Tag and content
+        uint32_t start = pc++;
+        while(pc < len && data[pc] != 0)
+            pc++;
+        pc++;
+        if(pc >= len)
+            return -HDL_ERR_PARSE;
+        _hdl_imagePut(&image, &data[start], pc - start);
+
+        // Attribute count, written when known
+        uint8_t attrs = data[pc++];
+        uint8_t kept = 0;
+        uint32_t countAt = image.pc;
+        _hdl_imagePut(&image, &kept, 1);
+
+        for(int a = 0; a < attrs; a++) {
+            if(pc + 3 > len)
+                return -HDL_ERR_PARSE;
+            start = pc;
+            uint8_t key = data[pc];
+            uint8_t type = data[pc + 1];
+            uint8_t count = data[pc + 2];
+            pc += 3;
+
+            if(type == HDL_TYPE_STRING) {
+                while(pc < len && data[pc] != 0)
+                    pc++;
+                pc++;
+            }
+            else if(type < sizeof(TYPE_SIZES)) {
+                pc += TYPE_SIZES[type] * count;
+            }
+            if(pc > len)
+                return -HDL_ERR_PARSE;
+
+            // Resolved again
+            if(key == HDL_ATTR_STATIC)
+                continue;
+            // Replaced by the static bounds, only the root is not laid out when they are not used
+            if(isStatic && _hdl_desc(interface, el)->parent != HDL_NO_ELEMENT && type != HDL_TYPE_BIND && key <= HDL_ATTR_HEIGHT)
+                continue;
+
+            _hdl_imagePut(&image, &data[start], pc - start);
+            kept++;
+        }
+
+        if(kept < 0xFF && isStatic) {
+            int16_t values[6] = { el->x, el->y, el->width, el->height, 0, 0 };
+            uint8_t attr[3] = { HDL_ATTR_STATIC, HDL_TYPE_I16, 4 };
+
+            struct HDL_ElementExt *ext = _hdl_getExt(interface, el);
+            if(_hdl_isStaticContent(interface, el, ext)) {
+                _hdl_layoutContent(interface, el, ext, &values[4], &values[5]);
+                attr[2] = 6;
+            }
+            _hdl_imagePut(&image, attr, sizeof(attr));
+            _hdl_imagePut(&image, values, sizeof(int16_t) * attr[2]);
+            kept++;
+        }
+
+        if(buffer != NULL && countAt < size)
+            buffer[countAt] = kept;
+
+        // Child count
+        if(pc >= len)
+            return -HDL_ERR_PARSE;
+        _hdl_imagePut(&image, &data[pc++], 1);
+    }
+
+    if(image.pc <= size && buffer != NULL) {
+        header.fileSize = image.pc;
+        memcpy(buffer, &header, sizeof(header));
+    }
+
+    return image.pc;
+}
+
+#ifdef HDL_CONF_BIND_COPIES
+int _hdl_checkBindings (struct HDL_Interface *interface) {
+    int update = 0;
+    for(int i = 0; i < HDL_CONF_MAX_BINDINGS; i++) {
+        if(interface->bindings[i].id != 0xFFFF && interface->bindings[i].id == interface->_bindings_cpy[i].id) {
+            int diff = 0;
+            if(interface->bindings[i].type == HDL_TYPE_STRING) {
+                diff = strcmp(interface->bindings[i].data, interface->_bindings_cpy[i].data);
+                strcpy(interface->_bindings_cpy[i].data, interface->bindings[i].data);
+            }
+            else {
+                diff = memcmp(interface->bindings[i].data, interface->_bindings_cpy[i].data, TYPE_SIZES[interface->bindings[i].type]);
+                memcpy(interface->_bindings_cpy[i].data, interface->bindings[i].data, TYPE_SIZES[interface->bindings[i].type]);
+            }
+            if(diff != 0) {
+                update = 1;
+                interface->_changedSlots |= 1UL << (i % 32);
+                // Do not break here to update other bindings too
+            }
+        }
+    }
+    return update;
+}
+#endif
+
+// Calculates the next time HDL_Update has work to do
+void _hdl_updateDeadline (struct HDL_Interface *interface) {
+    uint64_t deadline = HDL_DEADLINE_NONE;
+
+    if(!interface->_updated || interface->_pending) {
+        // Render as soon as the minimum interval allows
+        deadline = interface->_updated ? interface->_lastUpdate + interface->minUpdateInterval : interface->_lastUpdate;
+    }
+
+    if(interface->maxUpdateInterval != 0) {
+        uint64_t forced = interface->_lastUpdate + interface->maxUpdateInterval;
+        if(forced < deadline)
+            deadline = forced;
+    }
+
+    // Next animation step, not before the minimum interval allows a render
+    for(int i = 0; i < HDL_CONF_MAX_ANIMATIONS; i++) {
+        struct HDL_Animation *anim = &interface->_animations[i];
+        if(!anim->active)
+            continue;
+
+        uint64_t next = anim->started ? anim->next : interface->_lastUpdate;
+        if(interface->_updated && next < interface->_lastUpdate + interface->minUpdateInterval)
+            next = interface->_lastUpdate + interface->minUpdateInterval;
+        if(next < deadline)
+            deadline = next;
+    }
+
+    interface->_nextDeadline = deadline;
+}
+
+// Adds an area to a rectangle, limited to the screen
+void _hdl_addArea (struct HDL_Interface *interface, struct HDL_Bounds *area, int16_t x, int16_t y, int16_t w, int16_t h) {
+    // Limit to the screen
+    if(x < 0) {
+        w += x;
+        x = 0;
+    }
+    if(y < 0) {
+        h += y;
+        y = 0;
+    }
+    if(x + w > interface->width)
+        w = interface->width - x;
+    if(y + h > interface->height)
+        h = interface->height - y;
+    if(w <= 0 || h <= 0)
+        return;
+
+    if(area->w == 0) {
+        area->x = x;
+        area->y = y;
+        area->w = w;
+        area->h = h;
+        return;
+    }
+
+    int16_t x2 = area->x + area->w > x + w ? area->x + area->w : x + w;
+    int16_t y2 = area->y + area->h > y + h ? area->y + area->h : y + h;
+    if(x < area->x)
+        area->x = x;
+    if(y < area->y)
+        area->y = y;
+    area->w = x2 - area->x;
+    area->h = y2 - area->y;
+}
+
+// Adds an area to the dirty rectangle
+void _hdl_markDirty (struct HDL_Interface *interface, int16_t x, int16_t y, int16_t w, int16_t h) {
+    _hdl_addArea(interface, &interface->_dirty, x, y, w, h);
+}
+
+// Marks the whole area of a text dirty
+void _hdl_markText (struct HDL_Interface *interface, const struct _hdl_Font *font, char *text, int16_t x, int16_t y, uint8_t size) {
+    uint16_t w, h;
+    _hdl_str_size(interface, font, text, &w, &h);
+    _hdl_markDirty(interface, x, y, w * size, h * size);
+}
+
+/**
+ * @brief Compares the content of an element with its last drawn text and marks the changed character cells dirty
+ * 
+ * @param interface 
+ * @param element 
+ * @param ext Element extension with content
+ * @return int 1 if the text was not drawn before and can not be compared
+ */
+int _hdl_diffText (struct HDL_Interface *interface, struct HDL_Element *element, struct HDL_ElementExt *ext) {
+    struct HDL_TextCache *cache = ext->text;
+    if(cache == NULL || cache->text == NULL)
+        return 1;
+
+    int16_t x, y;
+    _hdl_layoutContent(interface, element, ext, &x, &y);
+
+    uint8_t size = _hdl_attrs(interface, element)->size;
+    struct _hdl_Font font;
+    uint8_t proportional = ext->font != NULL && !_hdl_openFont(interface, ext->font, &font);
+
+    if(x != cache->x || y != cache->y || (proportional && strcmp(cache->text, interface->_contentBuffer) != 0)) {
+        // Text moved, e.g. centered text changed length. Core font glyphs are not in cells
+        _hdl_markText(interface, proportional ? &font : NULL, cache->text, cache->x, cache->y, size);
+        _hdl_markText(interface, proportional ? &font : NULL, interface->_contentBuffer, x, y, size);
+        return 0;
+    }
+    if(proportional)
+        return 0;
+
+    int16_t cw = (interface->textWidth + 1) * size;
+    int16_t ch = (interface->textHeight + 1) * size;
+    const char *prev = cache->text;
+    const char *cur = interface->_contentBuffer;
+
+    // Compare line by line, missing cells are blank
+    for(int16_t ly = y; *prev || *cur; ly += ch) {
+        int16_t first = -1;
+        int16_t last = -1;
+
+        for(int16_t col = 0; (*prev && *prev != '\n') || (*cur && *cur != '\n'); col++) {
+            char a = (*prev && *prev != '\n') ? *prev++ : ' ';
+            char b = (*cur && *cur != '\n') ? *cur++ : ' ';
+            if(a != b) {
+                if(first < 0)
+                    first = col;
+                last = col;
+            }
+        }
+        if(first >= 0)
+            _hdl_markDirty(interface, x + first * cw, ly, (last - first + 1) * cw, ch);
+
+        if(*prev == '\n')
+            prev++;
+        if(*cur == '\n')
+            cur++;
+    }
+    return 0;
+}
+
+// Invalidates the surfaces of cached subtrees containing the element
+void _hdl_invalidateCaches (struct HDL_Interface *interface, struct HDL_Element *element) {
+    while(1) {
+        struct HDL_ElementExt *ext = _hdl_getExt(interface, element);
+        if(ext != NULL && ext->cache != NULL)
+            ext->cache->valid = 0;
+        if(_hdl_desc(interface, element)->parent == HDL_NO_ELEMENT)
+            break;
+        element = &interface->elements[_hdl_desc(interface, element)->parent];
+    }
+}
+
+// Invalidates the surfaces not drawn by the update when a slot they depend on changed,
+// as hidden subtrees miss the change. Called before the changed slots are cleared
+void _hdl_expireCaches (struct HDL_Interface *interface) {
+    for(uint16_t i = 0; i < interface->elementExtCount; i++) {
+        struct HDL_SurfaceCache *cache = interface->elementExt[i].cache;
+        if(cache == NULL)
+            continue;
+        if(!cache->fresh && (cache->deps & interface->_changedSlots))
+            cache->valid = 0;
+        cache->fresh = 0;
+    }
+}
+
+// Returns the list an element is part of as a row template, NULL if none
+struct HDL_Element *_hdl_listOf (struct HDL_Interface *interface, struct HDL_Element *element) {
+    while(_hdl_desc(interface, element)->parent != HDL_NO_ELEMENT) {
+        element = &interface->elements[_hdl_desc(interface, element)->parent];
+        if(_hdl_desc(interface, element)->tag == HDL_TAG_LIST)
+            return element;
+    }
+    return NULL;
+}
+
+// Marks the rows of a drawn list whose item changed or scrolled into place
+void _hdl_diffList (struct HDL_Interface *interface, struct HDL_Element *list, struct HDL_ElementExt *ext, uint32_t changed) {
+    if(ext->list == NULL || _hdl_desc(interface, list)->first_child == HDL_NO_ELEMENT)
+        return;
+
+    uint16_t rowH = _hdl_rowHeight(interface, list, ext);
+    uint16_t rows = (list->height + 1) / rowH;
+    uint32_t arrayMask = ext->bind_count > 0 ? _hdl_bindingMask(interface, ext->bindings[0]) : 0;
+
+    if(_hdl_subtreeDeps(interface, &interface->elements[_hdl_desc(interface, list)->first_child]) & changed & ~arrayMask) {
+        // Every row depends on the change
+        _hdl_markDirty(interface, list->x, list->y, list->width + 1, rows * rowH + 1);
+        _hdl_invalidateCaches(interface, list);
+        return;
+    }
+
+    // New scroll offset
+    _hdl_handleBoundAttrs(interface, list);
+
+    const struct HDL_Array *array = _hdl_listArray(interface, ext);
+    for(uint16_t r = 0; r < rows; r++) {
+        if(r < HDL_CONF_LIST_ROWS && ext->list->rows[r] == _hdl_rowHash(array, _hdl_attrs(interface, list)->scroll + r))
+            continue;
+        _hdl_markDirty(interface, list->x, list->y + r * rowH, list->width + 1, rowH + 1);
+        _hdl_invalidateCaches(interface, list);
+    }
+}
+
+// Shifts a drawn scroll container to its new offset. Returns 1 if the whole screen should be rendered
+int _hdl_diffScroll (struct HDL_Interface *interface, struct HDL_Element *element, struct HDL_ElementExt *ext, uint32_t changed) {
+    uint32_t offsetMask = 0;
+    for(int a = 0; a < ext->boundAttrCount; a++) {
+        struct HDL_AttrBind *battr = &interface->attrBinds[ext->boundAttrs + a];
+        if(battr->key == HDL_ATTR_SCROLL)
+            offsetMask |= _hdl_bindingMask(interface, battr->bind.value);
+    }
+
+    // Only the offset of one container may change, other content would move with the pixels
+    if(interface->_scrolled != NULL || (_hdl_subtreeDeps(interface, element) & changed & ~offsetMask))
+        return 1;
+
+    int16_t old = _hdl_attrs(interface, element)->scroll;
+    _hdl_handleBoundAttrs(interface, element);
+    int16_t delta = _hdl_attrs(interface, element)->scroll - old;
+    if(delta == 0)
+        return 0;
+    // Descendants are laid out at the new offset
+    _hdl_hitMoved(interface, element);
+
+    int16_t dx = _hdl_attrs(interface, element)->flexDir == HDL_FLEX_COLUMN ? -delta : 0;
+    int16_t dy = _hdl_attrs(interface, element)->flexDir == HDL_FLEX_COLUMN ? 0 : -delta;
+    struct HDL_Bounds view;
+    _hdl_viewport(interface, element, &view);
+    _hdl_invalidateCaches(interface, element);
+
+    if(abs(dx) >= view.w || abs(dy) >= view.h || (interface->f_scroll == NULL && interface->f_copyRect == NULL)) {
+        // Nothing to reuse
+        _hdl_markDirty(interface, view.x, view.y, view.w, view.h);
+        return 0;
+    }
+
+    interface->_scrolled = element;
+    interface->_scrollX = dx;
+    interface->_scrollY = dy;
+
+    // Exposed strip
+    if(dx > 0)
+        _hdl_markDirty(interface, view.x, view.y, dx, view.h);
+    else if(dx < 0)
+        _hdl_markDirty(interface, view.x + view.w + dx, view.y, -dx, view.h);
+    else if(dy > 0)
+        _hdl_markDirty(interface, view.x, view.y, view.w, dy);
+    else
+        _hdl_markDirty(interface, view.x, view.y + view.h + dy, view.w, -dy);
+    return 0;
+}
+
+// Marks the chart columns with new samples, shifting the drawn ones when a column was added. Returns 1 if the whole screen should be rendered
+int _hdl_diffChart (struct HDL_Interface *interface, struct HDL_Element *element, struct HDL_ElementExt *ext) {
+    struct HDL_ChartState *state = ext->chart;
+    const struct HDL_Ring *ring = _hdl_chartRing(interface, ext);
+    struct HDL_Bounds plot;
+    _hdl_viewport(interface, element, &plot);
+    _hdl_invalidateCaches(interface, element);
+
+    if(ring == NULL || ring->capacity == 0 || plot.w == 0 || plot.h == 0 || !state->valid || state->written == 0 ||
+        ring->written < state->written || state->width != plot.w || state->step != _hdl_chartStep(ring, plot.w)) {
+        _hdl_markDirty(interface, plot.x, plot.y, plot.w, plot.h);
+        return 0;
+    }
+
+    uint16_t step = state->step;
+    int32_t last = (ring->written - 1) / step;
+    int32_t first = last - plot.w + 1;
+    int32_t shift = last - (int32_t)((state->written - 1) / step);
+
+    if(shift >= plot.w || (shift > 0 && interface->f_scroll == NULL && interface->f_copyRect == NULL)) {
+        _hdl_markDirty(interface, plot.x, plot.y, plot.w, plot.h);
+        return 0;
+    }
+    if(shift > 0) {
+        // Only one area is shifted per update
+        if(interface->_scrolled != NULL)
+            return 1;
+        interface->_scrolled = element;
+        interface->_scrollX = -shift;
+        interface->_scrollY = 0;
+    }
+
+    // Columns with new samples
+    int32_t fresh = state->written / step;
+    if(fresh < first)
+        fresh = first;
+    _hdl_markDirty(interface, plot.x + (fresh - first), plot.y, last - fresh + 1, plot.h);
+
+    // Columns losing samples as the buffer wraps, and the next one joined to them
+    if(ring->written > ring->capacity) {
+        int32_t truncated = (ring->written - ring->capacity) / step + 1;
+        if(truncated >= first)
+            _hdl_markDirty(interface, plot.x, plot.y, truncated - first + 1, plot.h);
+    }
+    return 0;
+}
+
+// Returns 1 if a bound attribute only changes the element's own area
+int _hdl_isMoveAttr (struct HDL_AttrBind *battr) {
+    return battr->count == 1 && (battr->key == HDL_ATTR_X || battr->key == HDL_ATTR_Y ||
+        battr->key == HDL_ATTR_WIDTH || battr->key == HDL_ATTR_HEIGHT || battr->key == HDL_ATTR_SPRITE);
+}
+
+// Returns 1 if an element or one of its ancestors is disabled
+int _hdl_isDisabled (struct HDL_Interface *interface, struct HDL_Element *element) {
+    for(;;) {
+        if(element->disabled)
+            return 1;
+        if(_hdl_desc(interface, element)->parent == HDL_NO_ELEMENT)
+            return 0;
+        element = &interface->elements[_hdl_desc(interface, element)->parent];
+    }
+}
+
+// Marks the old and new area of an element moved, resized or animated by bound attributes. Returns 1 if the whole screen should be rendered
+int _hdl_diffMove (struct HDL_Interface *interface, struct HDL_Element *element, struct HDL_ElementExt *ext, uint32_t changed) {
+    uint32_t moveMask = 0;
+    for(int a = 0; a < ext->boundAttrCount; a++) {
+        struct HDL_AttrBind *battr = &interface->attrBinds[ext->boundAttrs + a];
+        if(_hdl_isMoveAttr(battr))
+            moveMask |= _hdl_bindingMask(interface, battr->bind.value);
+    }
+
+    if(_hdl_subtreeDeps(interface, element) & changed & ~moveMask)
+        return 1;
+    if(!(element->flags & HDL_FLAG_VISIBLE)) {
+        // Moving may bring it into a scroll container's view
+        return !_hdl_isDisabled(interface, element);
+    }
+
+    _hdl_hitMoved(interface, element);
+    _hdl_markDirty(interface, element->x, element->y, element->width + 1, element->height + 1);
+    _hdl_handleBoundAttrs(interface, element);
+    _hdl_markDirty(interface, element->x, element->y, element->width + 1, element->height + 1);
+    _hdl_invalidateCaches(interface, element);
+    return 0;
+}
+
+/**
+ * @brief Collects the area affected by changed bindings to the dirty rectangle. 
+ * Only bound text, list rows, scroll offsets, chart samples and element bounds or sprites can be updated partially,
+ * any other change needs a full render
+ * 
+ * @param interface 
+ * @return int 1 if the whole screen should be rendered
+ */
+int _hdl_collectDirty (struct HDL_Interface *interface) {
+    uint32_t changed = interface->_changedSlots;
+
+    // Area changed by HDL_Rebuild
+    interface->_dirty = interface->_rebuilt;
+    interface->_rebuilt.w = 0;
+    interface->_rebuilt.h = 0;
+    interface->_scrolled = NULL;
+
+    // Unknown changes
+    if(changed == 0xFFFFFFFFUL || (changed == 0 && interface->_dirty.w == 0))
+        return 1;
+
+    for(uint16_t i = 0; i < interface->elementCount; i++) {
+        struct HDL_Element *element = &interface->elements[i];
+        struct HDL_ElementExt *ext = _hdl_getExt(interface, element);
+        if(ext == NULL)
+            continue;
+
+        // Row templates are compared by their list
+        if(_hdl_listOf(interface, element) != NULL)
+            continue;
+
+        // Bound attributes may change layout, scrolling only changes the content of lists and scroll containers
+        uint8_t scrolled = 0;
+        uint8_t moved = 0;
+        for(int a = 0; a < ext->boundAttrCount; a++) {
+            struct HDL_AttrBind *battr = &interface->attrBinds[ext->boundAttrs + a];
+            if(battr->count == 1) {
+                if(!(_hdl_bindingMask(interface, battr->bind.value) & changed))
+                    continue;
+                if(_hdl_isMoveAttr(battr)) {
+                    moved = 1;
+                    continue;
+                }
+                if((_hdl_desc(interface, element)->tag != HDL_TAG_LIST && _hdl_desc(interface, element)->tag != HDL_TAG_SCROLL) || battr->key != HDL_ATTR_SCROLL)
+                    return 1;
+                scrolled = 1;
+            }
+            else {
+                for(int v = 0; v < battr->count; v++) {
+                    if(_hdl_bindingMask(interface, battr->bind.values[v]) & changed)
+                        return 1;
+                }
+            }
+        }
+
+        uint32_t deps = 0;
+        for(int b = 0; b < ext->bind_count; b++) {
+            deps |= _hdl_bindingMask(interface, ext->bindings[b]);
+        }
+        if(moved) {
+            if(_hdl_diffMove(interface, element, ext, changed))
+                return 1;
+            continue;
+        }
+        if(_hdl_desc(interface, element)->tag == HDL_TAG_SCROLL && scrolled) {
+            if((element->flags & HDL_FLAG_VISIBLE) && _hdl_diffScroll(interface, element, ext, changed))
+                return 1;
+            continue;
+        }
+        if(_hdl_desc(interface, element)->tag == HDL_TAG_LIST) {
+            if((element->flags & HDL_FLAG_VISIBLE) && (scrolled || (_hdl_subtreeDeps(interface, element) & changed)))
+                _hdl_diffList(interface, element, ext, changed);
+            continue;
+        }
+        if(!(deps & changed) || !(element->flags & HDL_FLAG_VISIBLE))
+            continue;
+
+        if(ext->widget != NULL)
+            return 1;
+        if(ext->chart != NULL) {
+            if(_hdl_diffChart(interface, element, ext))
+                return 1;
+            continue;
+        }
+        if(ext->content == NULL)
+            continue;
+        if(_hdl_diffText(interface, element, ext))
+            return 1;
+
+        // Drawn directly to the screen
+        _hdl_invalidateCaches(interface, element);
+    }
+    return 0;
+}
+
+// Runtime flags kept for a matched element by HDL_Rebuild, the others follow from the record
+#define HDL_FLAGS_DRAWN (HDL_FLAG_CONTENT_CHANGED | HDL_FLAG_BOUNDS_CHANGED | HDL_FLAG_VISIBLE)
+
+// Moves the state of an unchanged element from the current tree to the new one
+void _hdl_keepElement (struct HDL_Interface *interface, struct HDL_Interface *old, uint16_t from, uint16_t to) {
+    struct HDL_Element *src = &old->elements[from];
+    struct HDL_Element *dst = &interface->elements[to];
+
+    // Layout of the last render
+    dst->x = src->x;
+    dst->y = src->y;
+    dst->width = src->width;
+    dst->height = src->height;
+    dst->disabled = src->disabled;
+    dst->flags = (dst->flags & ~HDL_FLAGS_DRAWN) | (src->flags & HDL_FLAGS_DRAWN);
+
+    struct HDL_ElementExt *srcExt = _hdl_getExt(old, src);
+    struct HDL_ElementExt *dstExt = _hdl_getExt(interface, dst);
+    if(srcExt == NULL || dstExt == NULL)
+        return;
+
+    // States are swapped, the unused ones are freed with the current tree
+    struct HDL_Attrs *attrs = dstExt->attrs;
+    dstExt->attrs = srcExt->attrs;
+    srcExt->attrs = attrs;
+    // Bound image, sprite and font may differ from the defaults resolved by the build
+    _hdl_resolveElement(interface, dst);
+
+    struct HDL_SurfaceCache *cache = dstExt->cache;
+    dstExt->cache = srcExt->cache;
+    srcExt->cache = cache;
+
+    struct HDL_TextCache *text = dstExt->text;
+    dstExt->text = srcExt->text;
+    srcExt->text = text;
+
+    struct HDL_ListState *list = dstExt->list;
+    dstExt->list = srcExt->list;
+    srcExt->list = list;
+
+    struct HDL_ScrollState *scroll = dstExt->scroll;
+    dstExt->scroll = srcExt->scroll;
+    srcExt->scroll = scroll;
+
+    struct HDL_ChartState *chart = dstExt->chart;
+    dstExt->chart = srcExt->chart;
+    srcExt->chart = chart;
+}
+
+// Rebuild traversal frame, a matched element in both trees
+struct _hdl_DiffFrame {
+    uint16_t old;
+    uint16_t new;
+    // Next child of the new tree
+    uint16_t next;
+    // First child of the current tree not matched yet
+    uint16_t cursor;
+    // Children were added, removed or changed
+    uint8_t changed;
+};
+
+/**
+ * @brief Matches the new tree to the current one in pre-order and moves the state of unchanged elements.
+ * Children are matched in order to the next current sibling with the same record, so added, removed and changed
+ * children only mark their parent's area to _rebuilt
+ * 
+ * @param interface Interface with the new tree
+ * @param old Interface with the current tree
+ * @return int 1 if the whole screen should be rendered
+ */
+int _hdl_diffTrees (struct HDL_Interface *interface, struct HDL_Interface *old) {
+    struct _hdl_DiffFrame stack[HDL_CONF_MAX_DEPTH];
+    int depth = 0;
+
+    if(interface->_elementHash == NULL || old->_elementHash == NULL || interface->_bitmapHash != old->_bitmapHash ||
+        interface->_staticLayout != old->_staticLayout || interface->_elementHash[0] != old->_elementHash[0])
+        return 1;
+
+    _hdl_keepElement(interface, old, 0, 0);
+    stack[depth].old = 0;
+    stack[depth].new = 0;
+    stack[depth].next = interface->elementDesc[0].first_child;
+    stack[depth].cursor = old->elementDesc[0].first_child;
+    stack[depth].changed = 0;
+    depth++;
+
+    while(depth > 0) {
+        struct _hdl_DiffFrame *frame = &stack[depth - 1];
+
+        if(frame->next == HDL_NO_ELEMENT) {
+            // Current children left were removed
+            if(frame->changed || frame->cursor != HDL_NO_ELEMENT) {
+                // Children are laid out again inside the parent
+                struct HDL_Element *parent = &interface->elements[frame->new];
+                if(parent->flags & HDL_FLAG_VISIBLE)
+                    _hdl_addArea(interface, &interface->_rebuilt, parent->x, parent->y, parent->width + 1, parent->height + 1);
+                _hdl_invalidateCaches(interface, parent);
+            }
+            depth--;
+            continue;
+        }
+
+        uint16_t child = frame->next;
+        frame->next = interface->elementDesc[child].next_sibling;
+
+        uint16_t match = frame->cursor;
+        while(match != HDL_NO_ELEMENT && old->_elementHash[match] != interface->_elementHash[child]) {
+            match = old->elementDesc[match].next_sibling;
+        }
+        if(match == HDL_NO_ELEMENT || depth >= HDL_CONF_MAX_DEPTH) {
+            // Added or changed, built from scratch
+            frame->changed = 1;
+            continue;
+        }
+        // Skipped siblings were removed
+        if(match != frame->cursor)
+            frame->changed = 1;
+        frame->cursor = old->elementDesc[match].next_sibling;
+
+        _hdl_keepElement(interface, old, match, child);
+        stack[depth].old = match;
+        stack[depth].new = child;
+        stack[depth].next = interface->elementDesc[child].first_child;
+        stack[depth].cursor = old->elementDesc[match].first_child;
+        stack[depth].changed = 0;
+        depth++;
+    }
+
+    return 0;
+}
+
+int HDL_Rebuild (struct HDL_Interface *interface, uint8_t *data, uint32_t len) {
+    if(interface == NULL)
+        return HDL_ERR_NO_ROOT;
+    if(interface->root == NULL)
+        return HDL_Build(interface, data, len);
+
+    // The current tree is kept aside until the new one is built
+    struct HDL_Interface *old = (struct HDL_Interface*)HMALLOC(sizeof(struct HDL_Interface));
+    if(old == NULL)
+        return HDL_ERR_MEMORY;
+    *old = *interface;
+    // Glyph cache and span batch stay with the interface
+    old->_glyphs = NULL;
+    old->_spans = NULL;
+
+    interface->root = NULL;
+    interface->elements = NULL;
+    interface->elementDesc = NULL;
+    interface->_descImage = 0;
+    interface->elementCount = 0;
+    interface->elementExt = NULL;
+    interface->elementExtCount = 0;
+    interface->_elementExtCap = 0;
+    interface->attrBinds = NULL;
+    interface->attrBindCount = 0;
+    interface->_attrBindCap = 0;
+    interface->bitmaps = NULL;
+    interface->bitmapCount = 0;
+    interface->bitmapStats.used = 0;
+    interface->_pages = NULL;
+    interface->_pageCount = 0;
+    interface->_pageCap = 0;
+    interface->pageStats.used = 0;
+    interface->_elementHash = NULL;
+    interface->_hitCells = NULL;
+    interface->_hitItems = NULL;
+    interface->_hitCap = 0;
+    interface->_hitValid = 0;
+
+    int err = HDL_Build(interface, data, len);
+    if(err) {
+        HDL_Free(interface);
+        *interface = *old;
+        HFREE(old);
+        return err;
+    }
+
+    // HDL_Build resets the widgets
+    memcpy(interface->widgets, old->widgets, sizeof(interface->widgets));
+    interface->widgetCount = old->widgetCount;
+    _hdl_resolveRefs(interface);
+
+    if(_hdl_diffTrees(interface, old)) {
+        // Rendered as a whole on the next update
+        interface->_updated = 0;
+    }
+    else if(interface->_rebuilt.w > 0) {
+        interface->_pending = 1;
+    }
+
+    // Glyphs may refer to the fonts of the current tree
+    if(interface->_glyphs != NULL)
+        memset(interface->_glyphs, 0, sizeof(struct HDL_GlyphCache) * HDL_CONF_GLYPH_CACHE);
+    HDL_Free(old);
+    HFREE(old);
+
+    _hdl_updateDeadline(interface);
+    return 0;
+}
+
+// Renders the whole screen
+void _hdl_render (struct HDL_Interface *interface) {
+    interface->f_clear(0, 0, interface->width, interface->height);
+
+    // Layout and visibility may change
+    interface->_hitValid = 0;
+    interface->_rebuilt.w = 0;
+    interface->_rebuilt.h = 0;
+
+    // Driver color may have been changed outside of rendering
+    interface->_color = HDL_COLOR_UNKNOWN;
+    // Default foreground
+    _hdl_handleElement(interface, interface->root, 0);
+
+    // Use partial refresh rather than full refresh if defined
+    if(interface->f_renderPart != NULL) {
+        interface->f_renderPart(0, 0, interface->width, interface->height);
+    }
+    else {
+        interface->f_render();
+    }
+}
+
+// Shifts the pixels of an area by dx, dy. Returns 0 if the driver cannot
+int _hdl_shift (struct HDL_Interface *interface, const struct HDL_Bounds *area, int16_t dx, int16_t dy) {
+    if(interface->f_scroll != NULL && interface->f_scroll(area->x, area->y, area->w, area->h, dx, dy) == 0)
+        return 1;
+    if(interface->f_copyRect == NULL)
+        return 0;
+
+    interface->f_copyRect(area->x - (dx < 0 ? dx : 0), area->y - (dy < 0 ? dy : 0), area->w - abs(dx), area->h - abs(dy),
+        area->x + (dx > 0 ? dx : 0), area->y + (dy > 0 ? dy : 0));
+    return 1;
+}
+
+// Redraws only the dirty rectangle
+void _hdl_renderDirty (struct HDL_Interface *interface) {
+    struct HDL_Bounds *dirty = &interface->_dirty;
+    struct HDL_Bounds view;
+
+    if(interface->_scrolled != NULL) {
+        // Shift the pixels of the scrolled container, only the exposed strip is dirty
+        _hdl_viewport(interface, interface->_scrolled, &view);
+        if(!_hdl_shift(interface, &view, interface->_scrollX, interface->_scrollY))
+            _hdl_markDirty(interface, view.x, view.y, view.w, view.h);
+    }
+
+    interface->f_clear(dirty->x, dirty->y, dirty->w, dirty->h);
+
+    interface->_clip = *dirty;
+    interface->_clipping = 1;
+    interface->_color = HDL_COLOR_UNKNOWN;
+    _hdl_handleElement(interface, interface->root, 0);
+    interface->_clipping = 0;
+
+    if(interface->_scrolled != NULL) {
+        // Shifted pixels are shown with the strip
+        _hdl_markDirty(interface, view.x, view.y, view.w, view.h);
+        interface->_scrolled = NULL;
+    }
+
+    if(interface->f_renderPart != NULL) {
+        interface->f_renderPart(dirty->x, dirty->y, dirty->w, dirty->h);
+    }
+    else {
+        interface->f_render();
+    }
+}
+
+// Integer easing, t and the result are in 0..1024
+int32_t _hdl_ease (enum HDL_Easing easing, int32_t t) {
+    switch(easing) {
+        case HDL_EASE_IN:
+            return t * t / 1024;
+        case HDL_EASE_OUT:
+            return 1024 - (1024 - t) * (1024 - t) / 1024;
+        case HDL_EASE_IN_OUT:
+            return t < 512 ? t * t / 512 : 1024 - (1024 - t) * (1024 - t) / 512;
+        default:
+            return t;
+    }
+}
+
+// Reads a number binding
+int32_t _hdl_readNumber (struct HDL_Binding *binding) {
+    switch(binding->type) {
+        case HDL_TYPE_BOOL:
+        case HDL_TYPE_I8:
+            return *(int8_t*)binding->data;
+        case HDL_TYPE_I16:
+            return *(int16_t*)binding->data;
+        case HDL_TYPE_I32:
+            return *(int32_t*)binding->data;
+        case HDL_TYPE_FLOAT:
+            return *(float*)binding->data;
+        default:
+            return 0;
+    }
+}
+
+// Writes a number binding. Returns 1 if the value changed
+int _hdl_writeNumber (struct HDL_Binding *binding, int32_t value) {
+    if(_hdl_readNumber(binding) == value)
+        return 0;
+
+    switch(binding->type) {
+        case HDL_TYPE_BOOL:
+        case HDL_TYPE_I8:
+            *(int8_t*)binding->data = value;
+            break;
+        case HDL_TYPE_I16:
+            *(int16_t*)binding->data = value;
+            break;
+        case HDL_TYPE_I32:
+            *(int32_t*)binding->data = value;
+            break;
+        case HDL_TYPE_FLOAT:
+            *(float*)binding->data = value;
+            break;
+        default:
+            return 0;
+    }
+    return 1;
+}
+
+// Advances animations to the update time and writes their bindings
+void _hdl_stepAnimations (struct HDL_Interface *interface, uint64_t time) {
+    for(int i = 0; i < HDL_CONF_MAX_ANIMATIONS; i++) {
+        struct HDL_Animation *anim = &interface->_animations[i];
+        if(!anim->active)
+            continue;
+
+        struct HDL_Binding *binding = HDL_GetBinding(interface, anim->binding);
+        if(binding == NULL) {
+            anim->active = 0;
+            continue;
+        }
+
+        if(!anim->started) {
+            anim->start = time;
+            anim->started = 1;
+        }
+        uint32_t elapsed = (uint32_t)(time - anim->start);
+        int32_t value;
+
+        if(anim->easing == HDL_EASE_FRAMES) {
+            uint32_t count = anim->to - anim->from + 1;
+            uint32_t frame = elapsed / anim->duration;
+            if(!anim->loop && frame >= count - 1) {
+                frame = count - 1;
+                anim->active = 0;
+            }
+            value = anim->from + frame % count;
+            anim->next = anim->start + (uint64_t)(frame + 1) * anim->duration;
+        }
+        else if(elapsed >= anim->duration || anim->to == anim->from) {
+            value = anim->to;
+            anim->active = 0;
+        }
+        else {
+            int32_t range = anim->to - anim->from;
+            value = anim->from + (int64_t)range * _hdl_ease(anim->easing, (int64_t)elapsed * 1024 / anim->duration) / 1024;
+            // Average time between value steps
+            uint32_t step = anim->duration / (range < 0 ? -range : range);
+            anim->next = time + (step > 0 ? step : 1);
+            if(anim->next > anim->start + anim->duration)
+                anim->next = anim->start + anim->duration;
         }
-    }
 
-    if(parent == NULL) {
-        interface->root = el;
-        // Set width and height to maximum if root element
-        if(el->attrs.height == 0 && el->attrs.width == 0) {
-            el->attrs.width = interface->width - 1;
-            el->attrs.height = interface->height - 1;
+        if(_hdl_writeNumber(binding, value)) {
+            interface->_changedSlots |= _hdl_bindingMask(interface, anim->binding);
+            interface->_pending = 1;
         }
     }
+}
 
-    // Child count
-    el->child_count = (uint8_t)data[(*pc)];
-    (*pc)++;
+int HDL_Update (struct HDL_Interface *interface, uint64_t time) {
 
-    for(int i = 0; i < el->child_count; i++) {
-        el->children[i] = (uint8_t)(*elementIndex);
-        int err = _hdl_buildElement(interface, el, elementIndex, data, pc);
-        if(el->tag == HDL_TAG_SWITCH) {
-            // Set disabled value according to element's value
-            if(el->attrs.value == i) {
-                interface->elements[el->children[i]].attrs.disabled = 0;
-            }
-            else {
-                interface->elements[el->children[i]].attrs.disabled = 1;
-            }
+    if(interface->root == NULL)
+        return 0;
+
+    uint32_t delta = (uint32_t)(time - interface->_lastUpdate);
+
+    uint8_t force_render = 0;
+
+    // Animations write their bindings
+    _hdl_stepAnimations(interface, time);
+
+    // Pages switched away from are freed when idle
+    _hdl_reclaimPages(interface, time);
+
+    // Check bindings even when throttled, so the change is kept pending
+    if(_hdl_checkBindings(interface))
+        interface->_pending = 1;
+
+    // Too early
+    if(delta < interface->minUpdateInterval && interface->_updated) {
+        _hdl_updateDeadline(interface);
+        return 0;
+    }
+
+    // Force render
+    if((interface->maxUpdateInterval != 0 && delta >= interface->maxUpdateInterval) || !interface->_updated)
+        force_render = 1;
+
+    if(interface->_pending || force_render) {
+        int rendered = 1;
+
+        if(force_render || _hdl_collectDirty(interface)) {
+            _hdl_render(interface);
+        }
+        else if(interface->_dirty.w > 0) {
+            // Only changed text cells
+            _hdl_renderDirty(interface);
+        }
+        else {
+            // Nothing visible changed
+            rendered = 0;
         }
-        if(err) {
 
-            return HDL_ERR_PARSE;
+        if(rendered) {
+            interface->_lastUpdate = time;
+            interface->_updated = 1;
         }
+        interface->_pending = 0;
+        _hdl_expireCaches(interface);
+        interface->_changedSlots = 0;
+        _hdl_updateDeadline(interface);
+        return rendered;
     }
 
+    _hdl_updateDeadline(interface);
     return 0;
 }
 
-int _hdl_buildBitmap (struct HDL_Interface *interface, struct HDL_Bitmap *bmp, uint8_t *data, int *pc) {
+int HDL_ForceUpdate (struct HDL_Interface *interface) {
 
-    bmp->id = *(uint16_t*)&data[*pc];
-    (*pc) += 2;
-    bmp->size = *(uint16_t*)&data[*pc];
-    (*pc) += 2;
-    bmp->width = *(uint16_t*)&data[*pc];
-    (*pc) += 2;
-    bmp->height = *(uint16_t*)&data[*pc];
-    (*pc) += 2;
-    bmp->sprite_width = *(uint8_t*)&data[*pc];
-    (*pc) += 1;
-    bmp->sprite_height = *(uint8_t*)&data[*pc];
-    (*pc) += 1;
-    bmp->colorMode = data[*pc];
-    (*pc) += 1;
+    if(interface->root == NULL)
+        return 0;
 
-    bmp->data = HMALLOC(bmp->size);
-    memcpy(bmp->data, &data[*pc], bmp->size);
+    _hdl_render(interface);
 
-    (*pc) += bmp->size;
-    return 0;
+    interface->_updated = 1;
+    interface->_pending = 0;
+    _hdl_expireCaches(interface);
+    interface->_changedSlots = 0;
+    _hdl_updateDeadline(interface);
+    return 1;
 }
 
-int HDL_PreloadBitmap (struct HDL_Interface *interface, uint16_t id, uint8_t *data, int len) {
-    int pc = 0;
-    struct HDL_Bitmap *bmp;
-    if(len <= sizeof(struct HDL_Bitmap) + 1) {
-        return HDL_ERR_PARSE;
-    }
-
-    if(interface->bitmapCount_pl >= HDL_CONF_MAX_PRELOADED_IMAGES) {
-        return HDL_ERR_MEMORY;
-    }
+void HDL_NotifyChange (struct HDL_Interface *interface) {
+    if(interface == NULL)
+        return;
 
-    bmp = &interface->bitmaps_pl[interface->bitmapCount_pl];
+    interface->_pending = 1;
+#ifndef HDL_CONF_BIND_COPIES
+    // Unknown what changed, invalidate all cached subtrees. Binding copies find the changed slots on update
+    interface->_changedSlots = 0xFFFFFFFF;
+#endif
+    _hdl_updateDeadline(interface);
+}
 
-    bmp->id = id;
-    pc += 2;
-    bmp->size = *(uint16_t*)&data[pc];
-    pc += 2;
-    bmp->width = *(uint16_t*)&data[pc];
-    pc += 2;
-    bmp->height = *(uint16_t*)&data[pc];
-    pc += 2;
-    bmp->sprite_width = *(uint8_t*)&data[pc];
-    pc += 1;
-    bmp->sprite_height = *(uint8_t*)&data[pc];
-    pc += 1;
-    bmp->colorMode = data[pc];
-    pc += 1;
+uint64_t HDL_GetNextDeadline (struct HDL_Interface *interface) {
+    if(interface == NULL || interface->root == NULL)
+        return HDL_DEADLINE_NONE;
 
-    bmp->data = &data[pc];
+    return interface->_nextDeadline;
+}
 
-    interface->bitmapCount_pl++;
+// Starts an animation of a number binding, replacing a running one
+int _hdl_startAnimation (struct HDL_Interface *interface, uint16_t id, int32_t from, int32_t to, uint32_t duration, enum HDL_Easing easing, uint8_t loop) {
+    struct HDL_Binding *binding = HDL_GetBinding(interface, id);
+    if(binding == NULL || (binding->type != HDL_TYPE_BOOL && binding->type != HDL_TYPE_I8 &&
+        binding->type != HDL_TYPE_I16 && binding->type != HDL_TYPE_I32 && binding->type != HDL_TYPE_FLOAT))
+        return HDL_ERR_NOT_FOUND;
+
+    struct HDL_Animation *anim = NULL;
+    for(int i = 0; i < HDL_CONF_MAX_ANIMATIONS; i++) {
+        struct HDL_Animation *a = &interface->_animations[i];
+        if(a->active && a->binding == id) {
+            anim = a;
+            break;
+        }
+        if(!a->active && anim == NULL)
+            anim = a;
+    }
+    if(anim == NULL)
+        return HDL_ERR_MEMORY;
 
+    anim->binding = id;
+    anim->from = from;
+    anim->to = to;
+    anim->duration = duration > 0 ? duration : 1;
+    anim->easing = easing;
+    anim->loop = loop;
+    anim->started = 0;
+    anim->active = 1;
+    _hdl_updateDeadline(interface);
     return 0;
 }
 
-int HDL_AddWidget (struct HDL_Interface *interface, uint16_t id, void (*render)(struct HDL_Interface*, const struct HDL_Element*)) {
+int HDL_Tween (struct HDL_Interface *interface, uint16_t id, int32_t to, uint32_t duration, enum HDL_Easing easing) {
+    struct HDL_Binding *binding = HDL_GetBinding(interface, id);
+    if(binding == NULL || easing == HDL_EASE_FRAMES)
+        return HDL_ERR_NOT_FOUND;
 
-    if(interface->widgetCount >= HDL_CONF_MAX_WIDGETS) {
-        return HDL_ERR_MEMORY;
-    }
-    struct HDL_Widget *widget = &interface->widgets[interface->widgetCount++];
-    widget->id = id;
-    widget->widget = render;
+    return _hdl_startAnimation(interface, id, _hdl_readNumber(binding), to, duration, easing, 0);
+}
 
-    return 0;
+int HDL_AnimateSprite (struct HDL_Interface *interface, uint16_t id, uint8_t first, uint8_t count, uint32_t frameTime, uint8_t loop) {
+    if(count == 0)
+        return HDL_ERR_NOT_FOUND;
+
+    return _hdl_startAnimation(interface, id, first, first + count - 1, frameTime, HDL_EASE_FRAMES, loop);
 }
 
-// Returns the bitmap. If not found returns NULL
-struct HDL_Bitmap *_hdl_getBitmap (struct HDL_Interface *interface, uint16_t id) {
-    // Bitmaps from files
-    for(int i = 0; i < interface->bitmapCount; i++) {
-        if(interface->bitmaps[i].id == id) {
-            return &interface->bitmaps[i];
-        }
-    }
-    // Preloaded bitmaps
-    for(int i = 0; i < interface->bitmapCount_pl; i++) {
-        if(interface->bitmaps_pl[i].id == id) {
-            return &interface->bitmaps_pl[i];
-        }
+void HDL_StopAnimation (struct HDL_Interface *interface, uint16_t id) {
+    for(int i = 0; i < HDL_CONF_MAX_ANIMATIONS; i++) {
+        if(interface->_animations[i].binding == id)
+            interface->_animations[i].active = 0;
     }
-    // Not found
-    return NULL;
+    _hdl_updateDeadline(interface);
 }
 
-int HDL_Build (struct HDL_Interface *interface, uint8_t *data, uint32_t len) {
-    
-    if(len < sizeof(struct HDL_Header)) {
-        // File too short
-        return HDL_ERR_PARSE;
+// Gets the area where an element can be hit, limited to the screen and scroll container views. Returns 0 if empty
+int _hdl_hitBox (struct HDL_Interface *interface, struct HDL_Element *element, struct HDL_Bounds *box) {
+    int16_t x1 = element->x > 0 ? element->x : 0;
+    int16_t y1 = element->y > 0 ? element->y : 0;
+    int16_t x2 = element->x + element->width + 1;
+    int16_t y2 = element->y + element->height + 1;
+
+    box->x = x1;
+    box->y = y1;
+    box->w = x2 > x1 ? x2 - x1 : 0;
+    box->h = y2 > y1 ? y2 - y1 : 0;
+
+    struct HDL_Bounds screen = {0, 0, interface->width, interface->height};
+    _hdl_intersect(box, &screen, box);
+
+    for(struct HDL_Element *e = element; _hdl_desc(interface, e)->parent != HDL_NO_ELEMENT && box->w > 0 && box->h > 0; ) {
+        e = &interface->elements[_hdl_desc(interface, e)->parent];
+        if(_hdl_desc(interface, e)->tag == HDL_TAG_SCROLL) {
+            struct HDL_Bounds view;
+            _hdl_viewport(interface, e, &view);
+            _hdl_intersect(box, &view, box);
+        }
     }
-    // Header should be at the start
-    struct HDL_Header *header = (struct HDL_Header*)data;
-
-    // Start point just after header
-    int pc = sizeof(struct HDL_Header);
+    return box->w > 0 && box->h > 0;
+}
 
-    // Allocate bitmaps
-    interface->bitmapCount = header->bitmapCount;
-    interface->bitmaps = (struct HDL_Bitmap*)HMALLOC(sizeof(struct HDL_Bitmap) * interface->bitmapCount);
+// Returns 1 if an element is indexed for hit testing
+int _hdl_hitIndexed (struct HDL_Interface *interface, struct HDL_Element *element, struct HDL_Bounds *box) {
+    return (element->flags & HDL_FLAG_VISIBLE) && _hdl_listOf(interface, element) == NULL && _hdl_hitBox(interface, element, box);
+}
 
-    if(interface->bitmaps == NULL)
-        return HDL_ERR_MEMORY;
+// Adds a subtree moved by a partial update to the hit test grid update, called before it moves
+void _hdl_hitMoved (struct HDL_Interface *interface, struct HDL_Element *element) {
+    // Rebuilt anyway
+    if(!interface->_hitValid)
+        return;
 
-    // Widgets
-    interface->widgetCount = 0;
-    for(int i = 0; i < HDL_CONF_MAX_WIDGETS; i++) {
-        interface->widgets[i].id = 0xFFFF;
-        interface->widgets[i].widget = NULL;
+    uint16_t start = element - interface->elements;
+    uint16_t end = _hdl_subtreeEnd(interface, element);
+    struct HDL_Bounds box;
+    for(uint16_t i = start; i < end; i++) {
+        if(_hdl_hitIndexed(interface, &interface->elements[i], &box))
+            _hdl_addArea(interface, &interface->_hitArea, box.x, box.y, box.w, box.h);
     }
 
-    // Allocate vartable TODO:
+    // Elements between moved subtrees are updated too, their hit boxes did not change
+    if(interface->_hitStart == interface->_hitEnd) {
+        interface->_hitStart = start;
+        interface->_hitEnd = end;
+    }
+    else {
+        if(start < interface->_hitStart)
+            interface->_hitStart = start;
+        if(end > interface->_hitEnd)
+            interface->_hitEnd = end;
+    }
+}
 
-    // Allocate elements
-    interface->elementCount = header->elementCount;
-    interface->elements = (struct HDL_Element*)HMALLOC(sizeof(struct HDL_Element) * interface->elementCount);
+// Builds the hit test grid from the drawn layout
+int _hdl_buildHitGrid (struct HDL_Interface *interface) {
+    uint16_t cols = (interface->width + HDL_CONF_HIT_CELL - 1) / HDL_CONF_HIT_CELL;
+    uint16_t rows = (interface->height + HDL_CONF_HIT_CELL - 1) / HDL_CONF_HIT_CELL;
+    uint16_t cells = cols * rows;
 
-    if(interface->elements == NULL)
+    if(interface->_hitCells == NULL) {
+        interface->_hitCells = HMALLOC((cells + 1) * sizeof(uint16_t));
+        if(interface->_hitCells == NULL)
+            return HDL_ERR_MEMORY;
+    }
+    uint16_t *start = interface->_hitCells;
+    memset(start, 0, (cells + 1) * sizeof(uint16_t));
+
+    // Count elements per cell, offset by one for the prefix sum
+    struct HDL_Bounds box;
+    uint32_t total = 0;
+    for(uint16_t i = 0; i < interface->elementCount; i++) {
+        if(!_hdl_hitIndexed(interface, &interface->elements[i], &box))
+            continue;
+        for(uint16_t cy = box.y / HDL_CONF_HIT_CELL; cy <= (box.y + box.h - 1) / HDL_CONF_HIT_CELL; cy++) {
+            for(uint16_t cx = box.x / HDL_CONF_HIT_CELL; cx <= (box.x + box.w - 1) / HDL_CONF_HIT_CELL; cx++) {
+                start[cy * cols + cx + 1]++;
+                total++;
+            }
+        }
+    }
+    if(total > 0xFFFF || _hdl_grow((void**)&interface->_hitItems, &interface->_hitCap, total, sizeof(uint16_t)))
         return HDL_ERR_MEMORY;
 
-    int err = 0;
-    for(int i = 0; i < interface->bitmapCount; i++) {
-        if((err = _hdl_buildBitmap(interface, &interface->bitmaps[i], data, &pc))) {
+    for(uint16_t c = 0; c < cells; c++) {
+        start[c + 1] += start[c];
+    }
 
-            return err;
+    // Fill in pre-order, start[c] is advanced to the end of cell c and shifted back afterwards
+    for(uint16_t i = 0; i < interface->elementCount; i++) {
+        if(!_hdl_hitIndexed(interface, &interface->elements[i], &box))
+            continue;
+        for(uint16_t cy = box.y / HDL_CONF_HIT_CELL; cy <= (box.y + box.h - 1) / HDL_CONF_HIT_CELL; cy++) {
+            for(uint16_t cx = box.x / HDL_CONF_HIT_CELL; cx <= (box.x + box.w - 1) / HDL_CONF_HIT_CELL; cx++) {
+                interface->_hitItems[start[cy * cols + cx]++] = i;
+            }
         }
     }
+    for(uint16_t c = cells; c > 0; c--) {
+        start[c] = start[c - 1];
+    }
+    start[0] = 0;
 
-    int elementIndex = 0;
-    // Start parsing elements
-    err = _hdl_buildElement(interface, NULL, &elementIndex, data, &pc);
-
-    return err;
+    interface->_hitValid = 1;
+    interface->_hitStart = interface->_hitEnd = 0;
+    interface->_hitArea.w = 0;
+    return 0;
 }
 
-#ifdef HDL_CONF_BIND_COPIES
-int _hdl_checkBindings (struct HDL_Interface *interface) {
-    int update = 0;
-    for(int i = 0; i < HDL_CONF_MAX_BINDINGS; i++) {
-        if(interface->bindings[i].id != 0xFFFF && interface->bindings[i].id == interface->_bindings_cpy[i].id) {
-            int diff = 0;
-            if(interface->bindings[i].type == HDL_TYPE_STRING) {
-                diff = strcmp(interface->bindings[i].data, interface->_bindings_cpy[i].data);
-                strcpy(interface->_bindings_cpy[i].data, interface->bindings[i].data);
-            }
-            else {
-                diff = memcmp(interface->bindings[i].data, interface->_bindings_cpy[i].data, TYPE_SIZES[interface->bindings[i].type]);
-                memcpy(interface->_bindings_cpy[i].data, interface->bindings[i].data, TYPE_SIZES[interface->bindings[i].type]);
-            }
-            if(diff != 0) {
-                update = 1;
-                // Do not break here to update other bindings too
+// Updates the cells of the hit area for the moved range. Items of the range are removed from the cells and
+// added again from the drawn layout, other items of the cells are kept
+int _hdl_updateHitGrid (struct HDL_Interface *interface) {
+    uint16_t cols = (interface->width + HDL_CONF_HIT_CELL - 1) / HDL_CONF_HIT_CELL;
+    uint16_t rows = (interface->height + HDL_CONF_HIT_CELL - 1) / HDL_CONF_HIT_CELL;
+    uint16_t cells = cols * rows;
+    uint16_t *start = interface->_hitCells;
+    uint16_t first = interface->_hitStart;
+    uint16_t last = interface->_hitEnd;
+
+    // Items added per cell, then the fill position of each cell
+    uint16_t *fill = HMALLOC(cells * sizeof(uint16_t));
+    if(fill == NULL)
+        return HDL_ERR_MEMORY;
+    memset(fill, 0, cells * sizeof(uint16_t));
+
+    // New hit boxes extend the area
+    struct HDL_Bounds box;
+    uint32_t added = 0;
+    for(uint16_t i = first; i < last; i++) {
+        if(!_hdl_hitIndexed(interface, &interface->elements[i], &box))
+            continue;
+        _hdl_addArea(interface, &interface->_hitArea, box.x, box.y, box.w, box.h);
+        for(uint16_t cy = box.y / HDL_CONF_HIT_CELL; cy <= (box.y + box.h - 1) / HDL_CONF_HIT_CELL; cy++) {
+            for(uint16_t cx = box.x / HDL_CONF_HIT_CELL; cx <= (box.x + box.w - 1) / HDL_CONF_HIT_CELL; cx++) {
+                fill[cy * cols + cx]++;
+                added++;
             }
         }
     }
-    return update;
-}
-#endif
-
-int HDL_Update (struct HDL_Interface *interface, uint64_t time) {
-
-    if(interface->root == NULL)
-        return 0;
 
-    uint32_t delta = (uint32_t)(time - interface->_lastUpdate);
-
-    uint8_t force_render = 0;
-
-    // Too early
-    if(delta < interface->minUpdateInterval && interface->_updated)
-        return 0;
-
-    // Force render
-    if((interface->maxUpdateInterval != 0 && delta >= interface->maxUpdateInterval) || !interface->_updated)
-        force_render = 1;
-
-    // Check bindings
-    if(_hdl_checkBindings(interface) || force_render) {
-
-        interface->f_clear(0, 0, interface->width, interface->height);
+    // Remove the items of the range from the cells of the area
+    struct HDL_Bounds *area = &interface->_hitArea;
+    uint16_t x1 = area->x / HDL_CONF_HIT_CELL, x2 = (area->x + area->w - 1) / HDL_CONF_HIT_CELL;
+    uint16_t y1 = area->y / HDL_CONF_HIT_CELL, y2 = (area->y + area->h - 1) / HDL_CONF_HIT_CELL;
+    uint16_t w = 0;
+    for(uint16_t c = 0; c < cells; c++) {
+        uint16_t from = start[c];
+        uint8_t inArea = area->w > 0 && c % cols >= x1 && c % cols <= x2 && c / cols >= y1 && c / cols <= y2;
+        start[c] = w;
+        for(uint16_t k = from; k < start[c + 1]; k++) {
+            uint16_t item = interface->_hitItems[k];
+            if(!inArea || item < first || item >= last)
+                interface->_hitItems[w++] = item;
+        }
+    }
+    start[cells] = w;
 
-        _hdl_handleElement(interface, interface->root);
+    uint32_t total = w + added;
+    if(total > 0xFFFF || _hdl_grow((void**)&interface->_hitItems, &interface->_hitCap, total, sizeof(uint16_t))) {
+        HFREE(fill);
+        return HDL_ERR_MEMORY;
+    }
 
-        /*
-        // TODO:
-        if(!force_render) {
-            // Check only visible elements
+    // Spread the cells from the last one, leaving room for the range after the items before it
+    uint16_t end = start[cells];
+    uint16_t newEnd = total;
+    for(uint16_t c = cells; c > 0; c--) {
+        uint16_t from = start[c - 1];
+        uint16_t split = from;
+        while(split < end && interface->_hitItems[split] < first) {
+            split++;
         }
-        */
+        uint16_t after = end - split;
+        uint16_t newStart = newEnd - (end - from) - fill[c - 1];
+        memmove(&interface->_hitItems[newEnd - after], &interface->_hitItems[split], after * sizeof(uint16_t));
+        memmove(&interface->_hitItems[newStart], &interface->_hitItems[from], (split - from) * sizeof(uint16_t));
+        fill[c - 1] = newStart + (split - from);
+        start[c] = newEnd;
+        end = from;
+        newEnd = newStart;
+    }
 
-        // Use partial refresh rather than full refresh if defined
-        if(interface->f_renderPart != NULL) {
-            // TODO: render only changed parts!
-            interface->f_renderPart(0, 0, interface->width, interface->height);
-        }
-        else {
-            interface->f_render();
+    // Fill in pre-order
+    for(uint16_t i = first; i < last; i++) {
+        if(!_hdl_hitIndexed(interface, &interface->elements[i], &box))
+            continue;
+        for(uint16_t cy = box.y / HDL_CONF_HIT_CELL; cy <= (box.y + box.h - 1) / HDL_CONF_HIT_CELL; cy++) {
+            for(uint16_t cx = box.x / HDL_CONF_HIT_CELL; cx <= (box.x + box.w - 1) / HDL_CONF_HIT_CELL; cx++) {
+                interface->_hitItems[fill[cy * cols + cx]++] = i;
+            }
         }
-        interface->_lastUpdate = time;
-        interface->_updated = 1;
-        return 1;
     }
+    HFREE(fill);
 
+    interface->_hitStart = interface->_hitEnd = 0;
+    interface->_hitArea.w = 0;
     return 0;
 }
 
-int HDL_ForceUpdate (struct HDL_Interface *interface) {
+struct HDL_Element *HDL_HitTest (struct HDL_Interface *interface, int16_t x, int16_t y) {
+    if(interface->root == NULL || x < 0 || y < 0 || x >= interface->width || y >= interface->height)
+        return NULL;
 
-    if(interface->root == NULL)
-        return 0;
+    if(!interface->_hitValid && _hdl_buildHitGrid(interface))
+        return NULL;
+    if(interface->_hitStart != interface->_hitEnd && _hdl_updateHitGrid(interface)) {
+        // Rebuilt on the next hit test
+        interface->_hitValid = 0;
+        return NULL;
+    }
 
-    
-    // TODO: clear screen?
-    interface->f_clear(0, 0, interface->width, interface->height);
+    uint16_t cols = (interface->width + HDL_CONF_HIT_CELL - 1) / HDL_CONF_HIT_CELL;
+    uint16_t cell = (y / HDL_CONF_HIT_CELL) * cols + x / HDL_CONF_HIT_CELL;
 
-    _hdl_handleElement(interface, interface->root);
+    // Later elements in pre-order are deeper or drawn over earlier siblings
+    for(uint16_t i = interface->_hitCells[cell + 1]; i > interface->_hitCells[cell]; i--) {
+        struct HDL_Element *element = &interface->elements[interface->_hitItems[i - 1]];
+        struct HDL_Bounds box;
+        _hdl_hitBox(interface, element, &box);
+        if(x >= box.x && x < box.x + box.w && y >= box.y && y < box.y + box.h)
+            return element;
+    }
+    return NULL;
+}
 
-    // Use partial refresh rather than full refresh if defined
-    if(interface->f_renderPart != NULL) {
-        // TODO: render only changed parts!
-        interface->f_renderPart(0, 0, interface->width, interface->height);
+void _hdl_freeExt (struct HDL_Interface *interface, struct HDL_ElementExt *ext) {
+    _hdl_release(interface, ext->bindings);
+
+    if(ext->cache != NULL) {
+        if(ext->cache->surface >= 0 && interface->f_surfaceFree != NULL)
+            interface->f_surfaceFree(ext->cache->surface);
+        HFREE(ext->cache);
     }
-    else {
-        interface->f_render();
+
+    if(ext->text != NULL) {
+        if(ext->text->text != NULL)
+            HFREE(ext->text->text);
+        HFREE(ext->text);
+    }
+
+    if(ext->list != NULL)
+        HFREE(ext->list);
+
+    if(ext->scroll != NULL)
+        HFREE(ext->scroll);
+
+    if(ext->chart != NULL) {
+        if(ext->chart->columns != NULL)
+            HFREE(ext->chart->columns);
+        HFREE(ext->chart);
     }
-    interface->_updated = 1;
-    return 1;
-}
 
-void _hdl_freeElement (struct HDL_Element *element) {
-    if(element->bindings != NULL)
-        HFREE(element->bindings);
+    if(ext->attrs != NULL)
+        HFREE(ext->attrs);
 
-    if(element->content != NULL)
-        HFREE(element->content);
+    _hdl_release(interface, ext->content);
 }
 
 void HDL_Free (struct HDL_Interface *interface) {
     // Free elements data
-    for(int i = 0; i < interface->elementCount; i++) {
-        _hdl_freeElement(&interface->elements[i]);
+    for(int i = 0; i < interface->elementExtCount; i++) {
+        _hdl_freeExt(interface, &interface->elementExt[i]);
+    }
+    if(interface->elementExt != NULL) {
+        HFREE(interface->elementExt);
+        interface->elementExt = NULL;
+    }
+    interface->elementExtCount = 0;
+    interface->_elementExtCap = 0;
+
+    // Free bound attributes
+    for(int i = 0; i < interface->attrBindCount; i++) {
+        if(interface->attrBinds[i].count > 1)
+            _hdl_release(interface, interface->attrBinds[i].bind.values);
+    }
+    if(interface->attrBinds != NULL) {
+        HFREE(interface->attrBinds);
+        interface->attrBinds = NULL;
     }
+    interface->attrBindCount = 0;
+    interface->_attrBindCap = 0;
+
 #ifdef HDL_CONF_BIND_COPIES
     /*
     // These should be only freed when you want to free the whole interface, not only built elements
@@ -1182,7 +5487,70 @@ void HDL_Free (struct HDL_Interface *interface) {
     // Free elements
     if(interface->elements != NULL) {
         HFREE(interface->elements);
+        interface->elements = NULL;
+    }
+    if(interface->elementDesc != NULL) {
+        if(interface->_descImage)
+            _hdl_release(interface, interface->elementDesc);
+        else
+            HFREE((void*)interface->elementDesc);
+        interface->elementDesc = NULL;
+    }
+    interface->_descImage = 0;
+    // Free bitmaps
+    if(interface->bitmaps != NULL) {
+        for(int i = 0; i < interface->bitmapCount; i++) {
+            struct HDL_Bitmap *bmp = &interface->bitmaps[i];
+            // Lazily loaded data is always allocated
+            if(bmp->offset != 0) {
+                if(bmp->data != NULL)
+                    HFREE(bmp->data);
+            }
+            else {
+                _hdl_release(interface, bmp->data);
+            }
+        }
+        HFREE(interface->bitmaps);
+        interface->bitmaps = NULL;
+    }
+    interface->bitmapStats.used = 0;
+    // Glyph cache refers to the freed fonts
+    if(interface->_glyphs != NULL) {
+        HFREE(interface->_glyphs);
+        interface->_glyphs = NULL;
+    }
+    if(interface->_spans != NULL) {
+        HFREE(interface->_spans);
+        interface->_spans = NULL;
+    }
+    // Hit test grid refers to the freed elements
+    if(interface->_hitCells != NULL) {
+        HFREE(interface->_hitCells);
+        interface->_hitCells = NULL;
     }
+    if(interface->_hitItems != NULL) {
+        HFREE(interface->_hitItems);
+        interface->_hitItems = NULL;
+    }
+    interface->_hitCap = 0;
+    interface->_hitValid = 0;
+    // Switch pages
+    if(interface->_pages != NULL) {
+        HFREE(interface->_pages);
+        interface->_pages = NULL;
+    }
+    interface->_pageCount = 0;
+    interface->_pageCap = 0;
+    interface->pageStats.used = 0;
+    interface->_source = NULL;
+    interface->_elementIndex = NULL;
+    if(interface->_elementHash != NULL) {
+        HFREE(interface->_elementHash);
+        interface->_elementHash = NULL;
+    }
+    interface->root = NULL;
+    // Next build is rendered as a whole
+    interface->_updated = 0;
 }
 
 void HDL_SetUpdateInterval (struct HDL_Interface *interface, uint16_t min, uint16_t max) {
@@ -1191,4 +5559,6 @@ void HDL_SetUpdateInterval (struct HDL_Interface *interface, uint16_t min, uint1
 
     interface->minUpdateInterval = min;
     interface->maxUpdateInterval = max;
+
+    _hdl_updateDeadline(interface);
 }
\ No newline at end of file
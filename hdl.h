@@ -19,8 +19,34 @@
 // Dirty - content changed
 #define HDL_FLAG_CONTENT_CHANGED        0b1
 // Dirty - bounds changed
-#define HDL_FLAG_BOUNDS_CHANGED         0b01
+#define HDL_FLAG_BOUNDS_CHANGED         0b10
+// Subtree is rendered once to an off-screen surface and composited from it
+#define HDL_FLAG_CACHE                  0b100
+// Element is shown on the screen
+#define HDL_FLAG_VISIBLE                0b1000
+// Bounds were resolved by HDL_Precompile, the element is not laid out
+#define HDL_FLAG_STATIC                 0b10000
+// Content position was resolved by HDL_Precompile, the content is not measured
+#define HDL_FLAG_STATIC_CONTENT         0b100000
+// Switch page whose descendants are built on activation, see HDL_SetPageCache
+#define HDL_FLAG_PAGE                   0b1000000
 
+// .hdl features, HDL_Header.features
+// Static elements carry absolute bounds from HDL_Precompile
+#define HDL_FILE_STATIC_LAYOUT  0x01
+
+
+// Element index of a missing parent, child or sibling
+#define HDL_NO_ELEMENT      0xFFFF
+
+// Driver color is not known
+#define HDL_COLOR_UNKNOWN   0xFFFFFFFFUL
+
+// No color. Foreground is inherited from the parent, background is not filled
+#define HDL_COLOR_NONE      0xFF
+
+// Returned by HDL_GetNextDeadline when nothing is scheduled
+#define HDL_DEADLINE_NONE   0xFFFFFFFFFFFFFFFFULL
 
 #define HDL_FLEX_ROW            0x01
 #define HDL_FLEX_COLUMN         0x02
@@ -29,10 +55,20 @@
 #define HDL_ERR_NO_ROOT     1
 #define HDL_ERR_PARSE       2
 #define HDL_ERR_MEMORY      3
+#define HDL_ERR_DEPTH       4
+#define HDL_ERR_NOT_FOUND   5
+#define HDL_ERR_VERSION     6
+#define HDL_ERR_IN_USE      7
 
 // Tagnames
 #define HDL_TAG_BOX         0
 #define HDL_TAG_SWITCH      1
+// Virtualized list. The first child is the row template, drawn once for each visible item of the bound array
+#define HDL_TAG_LIST        2
+// Scroll container. Children are stacked along the flex direction at their own size and shifted by the scroll attribute
+#define HDL_TAG_SCROLL      3
+// Trend chart of a ring buffer binding, one min/max column per group of samples with the newest on the right
+#define HDL_TAG_CHART       4
 
 enum HDL_Type {
     HDL_TYPE_NULL       = 0,
@@ -44,6 +80,8 @@ enum HDL_Type {
     HDL_TYPE_I32        = 6,
     HDL_TYPE_IMG        = 7,
     HDL_TYPE_BIND       = 8,
+    HDL_TYPE_ARRAY      = 9,
+    HDL_TYPE_RING       = 10,
 
     // Tell's how many types have been defined
     HDL_TYPE_COUNT
@@ -68,8 +106,38 @@ enum HDL_AttrIndex {
     HDL_ATTR_WIDGET     = 14, // Widget
     HDL_ATTR_BORDER     = 15, // Border
     HDL_ATTR_RADIUS     = 16, // Radius
+    HDL_ATTR_CACHE      = 17, // Cache subtree to an off-screen surface
+    HDL_ATTR_FILL       = 18, // Fill background
+    HDL_ATTR_COLOR      = 19, // Foreground color, palette index
+    HDL_ATTR_BACKGROUND = 20, // Background color, palette index. Fills the background
+    HDL_ATTR_FONT       = 21, // Font bitmap. Text is drawn by the core instead of f_text
+    HDL_ATTR_SCROLL     = 22, // First visible list row, or scroll container offset in pixels
+    HDL_ATTR_RANGE      = 23, // Chart value range, min and max
+    HDL_ATTR_STATIC     = 24, // Absolute x, y, width, height and optionally content x, y. Written by HDL_Precompile
+};
+
+
+// Array binding data, HDL_TYPE_ARRAY. Content bound to the array shows the item of the list row being drawn
+struct HDL_Array {
+    // Items, char pointers for HDL_TYPE_STRING
+    const void *items;
+    // Item type
+    enum HDL_Type type;
+    // Item count
+    uint16_t count;
+    // Increment when items are changed in place
+    uint16_t version;
 };
 
+// Ring buffer binding data, HDL_TYPE_RING
+struct HDL_Ring {
+    // Samples, the newest is at (written - 1) % capacity
+    const int16_t *samples;
+    // Sample count of the buffer
+    uint16_t capacity;
+    // Samples written so far
+    uint32_t written;
+};
 
 // HDL Colorspace 
 enum HDL_ColorSpace {
@@ -82,6 +150,18 @@ enum HDL_ColorSpace {
     HDL_COLORS_PALLETTE
 };
 
+// Bitmap pixel formats, low nibble of HDL_Bitmap.colorMode
+// 1 bit per pixel packed rows, 0 bits are drawn
+#define HDL_BITMAP_MONO         0x00
+// 2 bits per pixel palette indices, data starts with 4 RGB palette entries. Index 0 is transparent
+#define HDL_BITMAP_PAL2         0x01
+// 4 bits per pixel palette indices, data starts with 16 RGB palette entries. Index 0 is transparent
+#define HDL_BITMAP_PAL4         0x02
+// Font, data is HDL_FontHeader followed by the glyphs, kerning pairs and glyph atlas
+#define HDL_BITMAP_FONT         0x03
+// Pixel rows are PackBits compressed, OR'ed with the format
+#define HDL_BITMAP_RLE          0x10
+
 struct HDL_Bitmap {
     uint16_t id;
     uint16_t size;
@@ -91,6 +171,120 @@ struct HDL_Bitmap {
     uint8_t sprite_height;
     uint8_t colorMode;
     uint8_t *data;
+    // Offset of the data in the .hdl when loaded lazily, 0 if the data is resident
+    uint32_t offset;
+    // Last use, for LRU eviction
+    uint32_t _lastUse;
+};
+
+// Font data header. Followed by count HDL_Glyph, kernCount HDL_Kerning sorted by left and right character,
+// and the glyph atlas: height rows of (atlasWidth + 7) / 8 bytes, 0 bits are drawn like in mono bitmaps
+struct __attribute__((packed)) HDL_FontHeader {
+    // First character
+    uint8_t first;
+    // Glyph count
+    uint8_t count;
+    // Glyph height. Lines are height + 1 apart
+    uint8_t height;
+    // Kerning pair count
+    uint8_t kernCount;
+    // Atlas width in pixels
+    uint16_t atlasWidth;
+};
+
+struct __attribute__((packed)) HDL_Glyph {
+    // Glyph position in the atlas
+    uint16_t x;
+    // Glyph width in the atlas
+    uint8_t width;
+    // Distance to the next glyph
+    uint8_t advance;
+};
+
+struct __attribute__((packed)) HDL_Kerning {
+    uint8_t left;
+    uint8_t right;
+    // Added to the advance of left when followed by right
+    int8_t adjust;
+};
+
+// Decoded ink runs of a glyph
+struct HDL_GlyphCache {
+    // Font, NULL if the entry is free
+    struct HDL_Bitmap *font;
+    // Character
+    uint8_t c;
+    // Run count
+    uint8_t count;
+    // Runs at size 1: x, y, length
+    uint8_t runs[HDL_CONF_GLYPH_RUNS][3];
+};
+
+// Lazy bitmap cache counters
+struct HDL_BitmapCacheStats {
+    // Draws that found the bitmap loaded
+    uint32_t hits;
+    // Draws that had to load the bitmap
+    uint32_t misses;
+    // Bitmaps evicted to stay within the budget
+    uint32_t evictions;
+    // Bytes currently loaded
+    uint32_t used;
+};
+
+// Switch page cache counters
+struct HDL_PageCacheStats {
+    // Pages built on activation
+    uint32_t builds;
+    // Pages freed when idle or over the budget
+    uint32_t frees;
+    // Bytes held by built pages
+    uint32_t used;
+};
+
+// Switch page built on activation
+struct HDL_Page {
+    // Page element, a child of the switch
+    uint16_t element;
+    // Descendants are built
+    uint8_t built;
+    // Bytes of the built descendants, kept as an estimate while not built
+    uint32_t bytes;
+    // Offset of the first descendant in the .hdl
+    uint32_t offset;
+    // Last update the page was shown
+    uint64_t lastUse;
+};
+
+// Asset store memory
+struct HDL_AssetStats {
+    // Shared bitmaps and fonts
+    uint16_t bitmaps;
+    // Interned document data blocks
+    uint16_t blobs;
+    // Bytes of interned document data
+    uint32_t bytes;
+    // Bytes not allocated because the data was already interned
+    uint32_t saved;
+};
+
+struct _hdl_Blob;
+
+// Assets shared by the interfaces attached with HDL_AttachAssets
+struct HDL_AssetStore {
+    // Bitmaps and fonts found by id after the bitmaps of the interface
+    struct HDL_Bitmap **bitmaps;
+    uint16_t _bitmapCap;
+
+    // Content, binding lists, multi-value attributes and bitmap data copied by HDL_Build
+    // and HDL_Restore, stored once for all interfaces. Sorted by hash
+    struct _hdl_Blob **_blobs;
+    uint16_t _blobCap;
+
+    // Attached interfaces
+    uint16_t users;
+
+    struct HDL_AssetStats stats;
 };
 
 // HDL File header
@@ -101,7 +295,57 @@ struct __attribute__((packed)) HDL_Header {
     uint8_t vartableCount;
     uint16_t elementCount;
     uint16_t fileSize;
-    uint8_t __padding[8]; // Reserved data
+    // HDL_FILE_* values OR'ed
+    uint8_t features;
+    // Screen size and text metrics a static layout was resolved for
+    uint16_t layoutWidth;
+    uint16_t layoutHeight;
+    uint8_t textWidth;
+    uint8_t textHeight;
+    uint8_t __padding[1]; // Reserved data
+};
+
+// HDL File header of format version 2. Followed by sectionCount HDL_Section entries.
+// Offsets are from the start of the file, sections are 4-byte aligned
+struct __attribute__((packed)) HDL_HeaderV2 {
+    // 2
+    uint8_t majorVersion;
+    uint8_t minorVersion;
+    // HDL_FILE_* values OR'ed
+    uint8_t features;
+    uint8_t sectionCount;
+    uint32_t fileSize;
+    // Screen size and text metrics a static layout was resolved for
+    uint16_t layoutWidth;
+    uint16_t layoutHeight;
+    uint8_t textWidth;
+    uint8_t textHeight;
+    uint8_t __padding[2]; // Reserved data
+};
+
+// Section types of a version 2 file
+// Bitmaps in version 1 encoding, count is the bitmap count
+#define HDL_SECTION_BITMAPS         1
+// uint32_t file offset of each bitmap
+#define HDL_SECTION_BITMAP_INDEX    2
+// Element stream in pre-order and version 1 encoding, count is the element count
+#define HDL_SECTION_ELEMENTS        3
+// HDL_ElementIndex of each element
+#define HDL_SECTION_ELEMENT_INDEX   4
+
+struct __attribute__((packed)) HDL_Section {
+    uint32_t type;
+    uint32_t offset;
+    uint32_t size;
+    // Entry count
+    uint32_t count;
+};
+
+// Element index entry of a version 2 file. The subtree of element i is elements i to i + descendants
+struct __attribute__((packed)) HDL_ElementIndex {
+    // File offset of the element
+    uint32_t offset;
+    uint32_t descendants;
 };
 
 #ifdef HDL_CONF_USE_KVP_ATTR
@@ -115,20 +359,8 @@ struct HDL_Attr {
     };
 };
 #else
-// All default attributes
+// Attributes of an element except its bounds and disabled flag, which are kept in HDL_Element
 struct HDL_Attrs {
-    // X position
-    int16_t x;
-    // Y position
-    int16_t y;
-    // Horizontal size
-    uint16_t width;
-    // Vertical size
-    uint16_t height;
-
-    // Disabled flag
-    uint8_t disabled;
-
     // Flex value
     uint8_t flex;
     // Flex direction
@@ -153,10 +385,20 @@ struct HDL_Attrs {
 
     // Widget index
     uint16_t widget;
+    // Font index
+    uint16_t font;
+    // First visible list row, or scroll container offset
+    uint16_t scroll;
     // Border
     uint8_t border;
     // Radius
     uint8_t radius;
+    // Fill background
+    uint8_t fill;
+    // Foreground color index
+    uint8_t color;
+    // Background color index
+    uint8_t background;
 };
 #endif
 
@@ -165,51 +407,144 @@ struct __attribute__((packed)) HDL_AttrBind {
     uint8_t key;
     union {
         uint16_t value;
-        uint16_t *values;    
+        const uint16_t *values;    
     } bind;
     uint8_t count;
 };
 
-// HDL Element
-struct HDL_Element {
-    // Element type
-    uint8_t tag;
-    
+struct HDL_Widget;
+
+// No element extension
+#define HDL_NO_EXT          0xFFFF
+
+// Off-screen surface of a cached subtree
+struct HDL_SurfaceCache {
+    // Driver surface handle, -1 if none
+    int16_t surface;
+    // Bounds the surface was rendered with
+    int16_t x;
+    int16_t y;
+    uint16_t w;
+    uint16_t h;
+    // Binding slots the subtree depends on, bit (slot % 32)
+    uint32_t deps;
+    // Surface holds the rendered subtree
+    uint8_t valid;
+    // Blitted or rendered by the current update
+    uint8_t fresh;
+};
+
+// Last drawn text of an element with bound content, for redrawing only changed character cells
+struct HDL_TextCache {
+    // Drawn text, NULL if not drawn yet
+    char *text;
+    // Allocated size of text
+    uint16_t cap;
+    // Position the text was drawn at
+    int16_t x;
+    int16_t y;
+};
+
+// Drawn rows of a list
+struct HDL_ListState {
+    // Data hash of each drawn row, 0 if the row was empty
+    uint32_t rows[HDL_CONF_LIST_ROWS];
+    // Row pitch, 0 until the list is first drawn
+    uint16_t rowHeight;
+};
+
+// Drawn columns of a chart
+struct HDL_ChartState {
+    // Minimum and maximum of each column, indexed by column % width. Empty if minimum > maximum
+    int16_t *columns;
+    // Plot width and samples per column the columns were computed for
+    uint16_t width;
+    uint16_t step;
+    // Samples written when last drawn
+    uint32_t written;
+    // Value range mapped to the plot height
+    int16_t min;
+    int16_t max;
+    // Columns are valid
+    uint8_t valid;
+};
+
+// Rarely used element data, kept in a side table only for elements that need it
+struct HDL_ElementExt {
     // Element content
-    char *content;
+    const char *content;
     // Bindings
-    uint16_t *bindings;
+    const uint16_t *bindings;
+    // Resolved image, NULL if not found
+    struct HDL_Bitmap *bitmap;
+    // Resolved widget, NULL if not found
+    struct HDL_Widget *widget;
+    // Resolved font, NULL if not found
+    struct HDL_Bitmap *font;
+    // Resolved sprite position in the image
+    uint16_t spriteX;
+    uint16_t spriteY;
+    // Content position if the element has HDL_FLAG_STATIC_CONTENT
+    int16_t contentX;
+    int16_t contentY;
+    // Surface cache if the element has HDL_FLAG_CACHE
+    struct HDL_SurfaceCache *cache;
+    // Last drawn text if the content has bindings
+    struct HDL_TextCache *text;
+    // Drawn rows if the element is a list
+    struct HDL_ListState *list;
+    // Clip state around the children of a scroll container
+    struct HDL_ScrollState *scroll;
+    // Column cache if the element is a chart
+    struct HDL_ChartState *chart;
+    // Attributes with bound values applied if the element has bound attributes
+    struct HDL_Attrs *attrs;
+    // Index of the first bound attribute in HDL_Interface.attrBinds
+    uint16_t boundAttrs;
+    // Bound attribute count
+    uint8_t boundAttrCount;
     // Binding count
     uint8_t bind_count;
-    // Flags
-    uint8_t flags;
-    // Parent element 
-    struct HDL_Element *parent;
-    // Children
-#ifdef HDL_CONF_STATIC_CHILDREN_COUNT
-    // 0xFF if the child does not exist
-    uint8_t children[HDL_CONF_STATIC_CHILDREN_COUNT];
-#else
-    // Dynamic children array
-    uint8_t *children;
-#endif
+};
+
+// Element description, constant after HDL_Build. Descriptions are stored in pre-order, in the same order as
+// HDL_Interface.elements. A resident HDL_Restore image supplies the table in place, e.g. from XIP flash
+struct HDL_ElementDesc {
+    // Element type
+    uint8_t tag;
+
+    // Index of the parent, HDL_NO_ELEMENT for root
+    uint16_t parent;
+    // Index of the first child, HDL_NO_ELEMENT if none
+    uint16_t first_child;
+    // Index of the next sibling, HDL_NO_ELEMENT if last
+    uint16_t next_sibling;
+    // Child count
+    uint16_t child_count;
 
 #ifdef HDL_CONF_USE_KVP_ATTR
     struct HDL_Attr *attrs;
 #else
+    // Attributes of the document, bound ones are kept in HDL_ElementExt.attrs
     struct HDL_Attrs attrs;
 #endif
-    // Bound attributes
-    struct HDL_AttrBind bound_attrs[HDL_CONF_MAX_ATTR_BINDINGS];
-    uint8_t boundAttrCount;
+};
 
+// HDL Element, the state that changes at runtime. Other data is in HDL_ElementDesc, see HDL_GetDesc and HDL_GetAttrs
+struct HDL_Element {
+    // Flags
+    uint8_t flags;
+    // Disabled by the document, a switch or a bound attribute
+    uint8_t disabled;
+    // Index in HDL_Interface.elementExt, HDL_NO_EXT if the element has no content, bindings, references
+    // or its page is not built
+    uint16_t ext;
 
-    // Child count
-#ifdef HDL_CONF_16BIT_CHILD_COUNT
-    uint16_t child_count;
-#else
-    uint8_t child_count;
-#endif
+    // Laid out position and size
+    int16_t x;
+    int16_t y;
+    uint16_t width;
+    uint16_t height;
 };
 
 struct HDL_Bounds {
@@ -219,6 +554,21 @@ struct HDL_Bounds {
     uint16_t h;
 };
 
+// Clip of the parent, restored after the children of a scroll container are drawn
+struct HDL_ScrollState {
+    struct HDL_Bounds clip;
+    struct HDL_Bounds view;
+    uint8_t clipping;
+    uint8_t viewing;
+};
+
+// Horizontal run of pixels, see HDL_Interface.f_spans
+struct HDL_Span {
+    int16_t x;
+    int16_t y;
+    int16_t len;
+};
+
 struct HDL_Interface;
 
 struct HDL_Widget {
@@ -232,6 +582,35 @@ struct HDL_Binding {
     enum HDL_Type type;
 };
 
+// Easing curves of HDL_Tween
+enum HDL_Easing {
+    HDL_EASE_LINEAR,
+    HDL_EASE_IN,
+    HDL_EASE_OUT,
+    HDL_EASE_IN_OUT,
+    // Sprite frame sequence, see HDL_AnimateSprite
+    HDL_EASE_FRAMES,
+};
+
+// Animation of a bound number, stepped by HDL_Update
+struct HDL_Animation {
+    // Start time, set by the first HDL_Update
+    uint64_t start;
+    // Next time the value changes
+    uint64_t next;
+    // Duration, or frame time of a sprite sequence
+    uint32_t duration;
+    // Start and end values, first and last frame of a sprite sequence
+    int32_t from;
+    int32_t to;
+    // Animated binding
+    uint16_t binding;
+    enum HDL_Easing easing;
+    uint8_t loop;
+    uint8_t started;
+    uint8_t active;
+};
+
 // HDL display interfaces
 struct HDL_Interface {
     // Width of the screen
@@ -248,10 +627,32 @@ struct HDL_Interface {
 
     // Array of all elements
     struct HDL_Element *elements;
+    // Descriptions of all elements
+    const struct HDL_ElementDesc *elementDesc;
+    // elementDesc is kept from a HDL_Restore image
+    uint8_t _descImage;
 
     // Element count
     uint16_t elementCount;
 
+    // HDL_SourceHash of the built .hdl, checked by HDL_Restore
+    uint32_t _sourceHash;
+    // Hash of each element record and of the bitmaps, compared by HDL_Rebuild. NULL without HDL_CONF_REBUILD
+    uint32_t *_elementHash;
+    uint32_t _bitmapHash;
+    // Static layout of the .hdl being built matches the interface
+    uint8_t _staticLayout;
+
+    // Element extensions
+    struct HDL_ElementExt *elementExt;
+    uint16_t elementExtCount;
+    uint16_t _elementExtCap;
+
+    // Bound attributes of all elements
+    struct HDL_AttrBind *attrBinds;
+    uint16_t attrBindCount;
+    uint16_t _attrBindCap;
+
     // Bindings
     struct HDL_Binding bindings[HDL_CONF_MAX_BINDINGS];
     #ifdef HDL_CONF_BIND_COPIES
@@ -263,13 +664,53 @@ struct HDL_Interface {
     struct HDL_Bitmap *bitmaps;
     uint16_t bitmapCount;
 
+    // Reference the .hdl or HDL_Restore image in place instead of copying content, binding lists
+    // and bitmap data to RAM, and the element descriptions of an image. The data must stay valid and unchanged
+    // until HDL_Free, e.g. in XIP flash.
+    // Set before HDL_Build or HDL_Restore
+    uint8_t residentDocument;
+
+    // Byte budget for lazily loaded bitmaps
+    uint32_t bitmapBudget;
+    // Lazy bitmap cache counters
+    struct HDL_BitmapCacheStats bitmapStats;
+    // Use counter for LRU
+    uint32_t _bitmapTick;
+
+    // Inactive switch pages are built on activation, see HDL_SetPageCache
+    uint8_t _lazyPages;
+    // Pages not shown for this many milliseconds are freed, 0 to keep them
+    uint32_t pageIdleTime;
+    // Byte budget of built pages, 0 for no limit
+    uint32_t pageBudget;
+    // Switch page cache counters
+    struct HDL_PageCacheStats pageStats;
+    struct HDL_Page *_pages;
+    uint16_t _pageCount;
+    uint16_t _pageCap;
+    // Built .hdl, pages are built from it
+    uint8_t *_source;
+    const struct HDL_ElementIndex *_elementIndex;
+
     // Bitmaps preloaded to HDL_Interface
     struct HDL_Bitmap bitmaps_pl[HDL_CONF_MAX_PRELOADED_IMAGES];
     uint16_t bitmapCount_pl;
 
+    // Shared asset store, see HDL_AttachAssets
+    struct HDL_AssetStore *assets;
+
     struct HDL_Widget widgets[HDL_CONF_MAX_WIDGETS];
     uint16_t widgetCount;
 
+    // Array item of the list row being drawn
+    uint16_t _listRow;
+    // List rows being drawn
+    uint8_t _inList;
+
+    // Glyph run cache of core fonts, HDL_CONF_GLYPH_CACHE entries allocated on the first glyph drawn
+    struct HDL_GlyphCache *_glyphs;
+    uint8_t _glyphNext;
+
     // Text width on size 1 font
     uint8_t textWidth;
     // Text height on size 1 font
@@ -278,6 +719,15 @@ struct HDL_Interface {
     // Width of the stroke. Can be implemented for hline/vline interfaces
     uint8_t strokeWidth;
 
+    // Color palette, RGB triplets. Element colors are indices to it
+    const uint8_t *palette;
+    // Palette entries
+    uint16_t paletteSize;
+    // Drawing color (0xRRGGBB) without a palette, restored after palette bitmaps. Should match the driver's default
+    uint32_t foreground;
+    // Color last passed to f_setColor (0xRRGGBB), HDL_COLOR_UNKNOWN if not known
+    uint32_t _color;
+
     // Maximum update interval (how long until screen is forced to refresh) in milliseconds. Set to 0 if no limit
     uint16_t maxUpdateInterval;
     // Minimum update interval (how long until screen can be refreshed) in milliseconds.
@@ -289,11 +739,61 @@ struct HDL_Interface {
     // Has the screen been updated
     uint8_t _updated;
 
+    // Change waiting for the minimum update interval
+    uint8_t _pending;
+
+    // Running animations
+    struct HDL_Animation _animations[HDL_CONF_MAX_ANIMATIONS];
+
+    // Hit test grid of HDL_CONF_HIT_CELL cells, rebuilt on the first hit test after a full render.
+    // Elements of cell i are _hitItems[_hitCells[i]] up to _hitItems[_hitCells[i + 1]], in pre-order
+    uint16_t *_hitCells;
+    uint16_t *_hitItems;
+    uint16_t _hitCap;
+    uint8_t _hitValid;
+    // Pre-order range of the subtrees moved by partial updates and the area of their hit boxes before the move.
+    // Only the cells of the area are updated on the next hit test
+    uint16_t _hitStart;
+    uint16_t _hitEnd;
+    struct HDL_Bounds _hitArea;
+
+    // Next time HDL_Update has work to do
+    uint64_t _nextDeadline;
+
+    // Binding slots changed since the last render, bit (slot % 32)
+    uint32_t _changedSlots;
+
+    // Cached subtree being rendered to its surface
+    struct HDL_Element *_captureRoot;
+
+    // Area to redraw on a partial update, empty if w is 0
+    struct HDL_Bounds _dirty;
+    // Area changed by HDL_Rebuild, redrawn on the next update
+    struct HDL_Bounds _rebuilt;
+    // Drawing is limited to _clip when set
+    struct HDL_Bounds _clip;
+    uint8_t _clipping;
+    // Viewport of the innermost scroll container when set, driver text is drawn only inside it
+    struct HDL_Bounds _view;
+    uint8_t _viewing;
+
+    // Scroll container shifted by the next partial update
+    struct HDL_Element *_scrolled;
+    int16_t _scrollX;
+    int16_t _scrollY;
+
+    // Shared buffer for formatted element content
+    char _contentBuffer[HDL_CONF_CONTENT_BUFFER_SIZE];
+
+    // Spans waiting for f_spans, HDL_CONF_SPAN_BATCH allocated on the first span
+    struct HDL_Span *_spans;
+    uint16_t _spanCount;
+
     // Display driver interfaces
 
     // Clear screen
     void (*f_clear)(int16_t x, int16_t y, uint16_t w, uint16_t h);
-    // Set color
+    // Set color. Called only when the drawing color changes
     void (*f_setColor)(uint8_t r, uint8_t g, uint8_t b);
     // Fast horizontal line
     void (*f_hline)(int16_t sx, int16_t sy, int16_t len);
@@ -303,8 +803,37 @@ struct HDL_Interface {
     void (*f_text)(int16_t x, int16_t y, const char *text, uint8_t fontSize);
     // Set pixel
     void (*f_pixel)(int16_t x, int16_t y);
-    // Draw arc
+    // Draw arc. Not used by the core, rounded borders are rasterized as f_hline spans
     void (*f_arc)(int16_t x, int16_t y, int16_t radius, uint16_t a1, uint16_t a2);
+    // Fill rectangle, optional. Borders and backgrounds fall back to spans
+    void (*f_fillRect)(int16_t x, int16_t y, uint16_t w, uint16_t h);
+    // Draw horizontal spans, optional. If set, spans are batched over the frame (up to HDL_CONF_SPAN_BATCH)
+    // and passed in one call instead of f_hline per span
+    void (*f_spans)(const struct HDL_Span *spans, uint16_t count);
+
+    // Scrolling, optional. When a scroll container's offset changes, its pixels are shifted
+    // and only the exposed strip is drawn. Without either op the whole container is redrawn
+
+    // Shift the pixels of an area by dx, dy in hardware. Returns 0 if done, otherwise f_copyRect is used
+    int (*f_scroll)(int16_t x, int16_t y, uint16_t w, uint16_t h, int16_t dx, int16_t dy);
+    // Copy an area of the screen to another position, the areas may overlap
+    void (*f_copyRect)(int16_t x, int16_t y, uint16_t w, uint16_t h, int16_t toX, int16_t toY);
+
+    // Load bitmap data from the .hdl. If set, HDL_Build only records bitmap descriptors
+    // and the data is loaded on first draw. Returns 0 on success
+    int (*f_loadBitmap)(uint32_t offset, uint8_t *buffer, uint16_t size);
+
+    // Off-screen surfaces, optional. Subtrees with the cache attribute are rendered once 
+    // to a surface and composited with one blit while nothing inside them changes
+
+    // Create a surface for the screen area, drawing to it uses screen coordinates. Returns handle or -1
+    int16_t (*f_surfaceCreate)(int16_t x, int16_t y, uint16_t w, uint16_t h);
+    // Redirect drawing to a surface, -1 draws to the screen
+    void (*f_surfaceSelect)(int16_t surface);
+    // Copy a surface to its area on the screen
+    void (*f_surfaceBlit)(int16_t surface);
+    // Free a surface
+    void (*f_surfaceFree)(int16_t surface);
 
     // Render the whole screen
     void (*f_render)();
@@ -313,31 +842,245 @@ struct HDL_Interface {
 
 };
 
-// Creates and initializes an interface
+// Initializes an interface in place, e.g. a static one, without the copy of HDL_CreateInterface
+void HDL_InitInterface (struct HDL_Interface *interface, uint16_t width, uint16_t height, enum HDL_ColorSpace colorSpace, int features);
+
+// Creates and initializes an interface, returned by value
 struct HDL_Interface HDL_CreateInterface (uint16_t width, uint16_t height, enum HDL_ColorSpace colorSpace, int features);
 
-// Builds the display
+// Builds the display from a version 1 or 2 .hdl. Returns HDL_ERR_VERSION for newer versions
 int HDL_Build (struct HDL_Interface *interface, uint8_t *data, uint32_t len);
 
-// Handle HDL updates
+/**
+ * @brief Replaces the built document with a new .hdl, keeping the state of unchanged elements.
+ * Elements are matched to the current tree by their record in the .hdl. Matched elements keep their layout,
+ * drawn text, surfaces, list, scroll and chart state, and only the parents of changed elements are redrawn on the next update.
+ * Bindings, widgets, preloaded bitmaps and settings are kept. Changed bitmaps or root redraw the whole screen
+ * 
+ * @param interface HDL interface, built or restored
+ * @param data New .hdl
+ * @param len Data length
+ * @return int 0 on success. On error the current document is kept
+*/
+int HDL_Rebuild (struct HDL_Interface *interface, uint8_t *data, uint32_t len);
+
+// Handle HDL updates. When only bound text changed, just the changed character cells are redrawn
 int HDL_Update (struct HDL_Interface *interface, uint64_t time);
 
+/**
+ * @brief Returns the hash of a .hdl, HDL_Restore only accepts images made from the same file.
+ * The hash can be computed when the .hdl is built to firmware and stored with the image
+ * 
+ * @param data .hdl data
+ * @param len Data length
+ * @return uint32_t FNV-1a hash
+*/
+uint32_t HDL_SourceHash (const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Writes the built state of the interface to an image that HDL_Restore can load instead of building the .hdl.
+ * The image has no pointers and can be stored anywhere. Preloaded bitmaps, widgets, bindings and
+ * drawn state are not included. Record hashes of HDL_CONF_REBUILD are, so HDL_Rebuild after HDL_Restore keeps unchanged elements.
+ * Call after HDL_Build. Fails with HDL_ERR_PARSE while a page of HDL_SetPageCache is not built
+ * 
+ * @param interface HDL interface
+ * @param buffer Image buffer, NULL to only get the size
+ * @param size Buffer size
+ * @return int32_t Image size, the image is complete only if it fits in size. Negative HDL_ERR_* on error
+*/
+int32_t HDL_Serialize (struct HDL_Interface *interface, uint8_t *buffer, uint32_t size);
+
+/**
+ * @brief Restores the built state from an image of HDL_Serialize. Call instead of HDL_Build, 
+ * widgets are added afterwards as usual. Lazily loaded bitmaps need the same loader as when the image was made
+ * 
+ * @param interface HDL interface
+ * @param image Image data, only referenced after the call with HDL_Interface.residentDocument. The element descriptions
+ * are then used in place and must be aligned to 2 bytes, so the image should start at an even address
+ * @param len Image length
+ * @param sourceHash HDL_SourceHash of the .hdl the image is expected to match
+ * @return int 0, HDL_ERR_VERSION if the image is from another .hdl or HDL version, HDL_ERR_PARSE or HDL_ERR_MEMORY
+*/
+int HDL_Restore (struct HDL_Interface *interface, const uint8_t *image, uint32_t len, uint32_t sourceHash);
+
+/**
+ * @brief Resolves the layout of static elements and writes a .hdl revision that carries it, 
+ * so the device does not lay them out or measure their content. Elements are static when nothing that moves them 
+ * is bound: their bounds, flex or disabled state, the bounds or flex direction of the parent, and none of their 
+ * ancestors is a switch, list or scroll container. Usually run on the host
+ * 
+ * @param interface HDL interface built from data, with the screen size, text metrics and fonts of the device.
+ * Call before rendering
+ * @param data Version 1 .hdl data
+ * @param len Data length
+ * @param buffer Output buffer, NULL to only get the size
+ * @param size Buffer size
+ * @return int32_t Output size, the output is complete only if it fits in size. Negative HDL_ERR_* on error
+*/
+int32_t HDL_Precompile (struct HDL_Interface *interface, const uint8_t *data, uint32_t len, uint8_t *buffer, uint32_t size);
+
 // Forces an update
 int HDL_ForceUpdate (struct HDL_Interface *interface);
 
+/**
+ * @brief Notifies HDL that bound data has changed. 
+ * The change is rendered on the next HDL_Update allowed by the minimum update interval
+ * 
+ * @param interface HDL interface
+*/
+void HDL_NotifyChange (struct HDL_Interface *interface);
+
+/**
+ * @brief Returns the next time HDL_Update should be called, in the same time base as HDL_Update.
+ * This is the earliest of a throttled pending change, the forced refresh time and animation steps.
+ * Bound data changes are only known after HDL_NotifyChange or an HDL_Update call, 
+ * so the caller can sleep until the deadline or until it changes data.
+ * 
+ * @param interface HDL interface
+ * @return uint64_t Deadline or HDL_DEADLINE_NONE if nothing is scheduled
+*/
+uint64_t HDL_GetNextDeadline (struct HDL_Interface *interface);
+
+/**
+ * @brief Finds the element at a screen position. Only drawn elements are found, 
+ * so disabled elements and inactive switch pages are skipped. List rows are found as their list
+ * 
+ * @param interface HDL interface
+ * @param x 
+ * @param y 
+ * @return struct HDL_Element* Deepest element containing the position, NULL if none
+ */
+struct HDL_Element *HDL_HitTest (struct HDL_Interface *interface, int16_t x, int16_t y);
+
+/**
+ * @brief Animates a bound number from its current value to a target. The animation starts on the next HDL_Update
+ * and the binding is written on every update until the duration has passed. Bound x, y, width, height and
+ * sprite attributes only redraw the area of the animated element
+ * 
+ * @param interface HDL interface
+ * @param id Binding id, an integer or float binding
+ * @param to Target value
+ * @param duration Duration in the time base of HDL_Update
+ * @param easing Easing curve
+ * @return int 0, HDL_ERR_NOT_FOUND if there is no such number binding or HDL_ERR_MEMORY if all animation slots are used
+ */
+int HDL_Tween (struct HDL_Interface *interface, uint16_t id, int32_t to, uint32_t duration, enum HDL_Easing easing);
+
+/**
+ * @brief Steps a bound sprite index through a frame sequence
+ * 
+ * @param interface HDL interface
+ * @param id Binding id, an integer binding
+ * @param first First sprite index
+ * @param count Frame count
+ * @param frameTime Time of one frame in the time base of HDL_Update
+ * @param loop Repeat until stopped, otherwise the last frame is kept
+ * @return int 0, HDL_ERR_NOT_FOUND if there is no such number binding or HDL_ERR_MEMORY if all animation slots are used
+ */
+int HDL_AnimateSprite (struct HDL_Interface *interface, uint16_t id, uint8_t first, uint8_t count, uint32_t frameTime, uint8_t loop);
+
+// Stops the animation of a binding, the binding keeps its current value
+void HDL_StopAnimation (struct HDL_Interface *interface, uint16_t id);
+
 // Cleanup
 void HDL_Free (struct HDL_Interface *interface);
 
 // Add a binding
 int HDL_SetBinding (struct HDL_Interface *interface, const char *key, uint16_t id, void *binding, enum HDL_Type type);
 
+// Get element content, NULL if the element has none
+const char *HDL_GetContent (struct HDL_Interface *interface, const struct HDL_Element *element);
+
+// Get element description
+const struct HDL_ElementDesc *HDL_GetDesc (struct HDL_Interface *interface, const struct HDL_Element *element);
+
+// Get element attributes, with bound values of the last render
+const struct HDL_Attrs *HDL_GetAttrs (struct HDL_Interface *interface, const struct HDL_Element *element);
+
 // Get a binding
 struct HDL_Binding *HDL_GetBinding (struct HDL_Interface *interface, uint16_t id);
 
 // Preload image
 int HDL_PreloadBitmap (struct HDL_Interface *interface, uint16_t id, uint8_t *data, int len);
 
-// Add widget
+/**
+ * @brief Preloads a font. Fonts can also be included in the .hdl as bitmaps with HDL_BITMAP_FONT format.
+ * Uses a preloaded image slot
+ * 
+ * @param interface HDL interface
+ * @param id Font id, referenced by the font attribute
+ * @param data HDL_FontHeader, glyphs, kerning pairs and atlas. Kept by reference
+ * @param len Data length
+ * @return int 0 on success
+*/
+int HDL_PreloadFont (struct HDL_Interface *interface, uint16_t id, uint8_t *data, int len);
+
+// Creates an empty asset store
+struct HDL_AssetStore HDL_CreateAssetStore (void);
+
+/**
+ * @brief Attaches an asset store to an interface, NULL detaches it. Call before HDL_Build or after HDL_Free.
+ * Bitmaps and fonts of the store are resolved by id when building, after the interface's own.
+ * Document data that would be copied to RAM is interned in the store, so identical content,
+ * binding lists and bitmaps of several interfaces are kept once. Resident documents are not copied
+ * 
+ * @param interface HDL interface
+ * @param store Asset store, must outlive the attachment
+ * @return int 0 on success, HDL_ERR_IN_USE if the interface is built
+*/
+int HDL_AttachAssets (struct HDL_Interface *interface, struct HDL_AssetStore *store);
+
+// Adds a bitmap to an asset store, the data is kept by reference. Add before building the interfaces using it
+int HDL_StoreBitmap (struct HDL_AssetStore *store, uint16_t id, uint8_t *data, int len);
+
+// Adds a font to an asset store, see HDL_PreloadFont. Add before building the interfaces using it
+int HDL_StoreFont (struct HDL_AssetStore *store, uint16_t id, uint8_t *data, int len);
+
+// Frees an asset store. Returns HDL_ERR_IN_USE while interfaces are attached
+int HDL_FreeAssets (struct HDL_AssetStore *store);
+
+/**
+ * @brief Loads bitmaps of the .hdl lazily through a loader. Call before HDL_Build.
+ * Loaded bitmaps are kept in an LRU cache, least recently drawn bitmaps are freed when the budget is exceeded
+ * 
+ * @param interface HDL interface
+ * @param loader Reads size bytes from offset of the .hdl to buffer, returns 0 on success
+ * @param budget Maximum bytes of loaded bitmap data
+*/
+void HDL_SetBitmapLoader (struct HDL_Interface *interface, int (*loader)(uint32_t offset, uint8_t *buffer, uint16_t size), uint32_t budget);
+
+/**
+ * @brief Builds the descendants of inactive switch pages when they are shown instead of in HDL_Build. Call before HDL_Build.
+ * HDL_Build still describes every element, a page build or free only adds or removes the extensions of its descendants:
+ * content, bindings, bound attributes and caches. The .hdl is referenced by the built interface and must stay valid until HDL_Free.
+ * Pages inside lists, cached subtrees and other pages are built with their parent
+ * 
+ * @param interface HDL interface
+ * @param idleTime Inactive pages are freed after this many milliseconds, 0 to keep them
+ * @param budget Built pages are freed least recently shown first to stay within this many bytes, 0 for no limit
+*/
+void HDL_SetPageCache (struct HDL_Interface *interface, uint32_t idleTime, uint32_t budget);
+
+/**
+ * @brief Sets the color palette. Element foreground and background colors are indices to the palette,
+ * index 0 is the default foreground. Colors are not set with no palette
+ * 
+ * @param interface HDL interface
+ * @param palette RGB triplets, kept by reference
+ * @param count Palette entries
+*/
+void HDL_SetPalette (struct HDL_Interface *interface, const uint8_t *palette, uint16_t count);
+
+/**
+ * @brief Adds a widget drawn by the elements with a matching widget attribute.
+ * The element passed to render holds only the laid out bounds, flags and disabled state.
+ * Widgets that read element->attrs or the tree links must use HDL_GetAttrs and HDL_GetDesc
+ *
+ * @param interface HDL interface
+ * @param id Widget id
+ * @param render Draws the element within its bounds
+ * @return int 0 on success, HDL_ERR_MEMORY if HDL_CONF_MAX_WIDGETS are added
+*/
 int HDL_AddWidget (struct HDL_Interface *interface, uint16_t id, void (*render)(struct HDL_Interface*, const struct HDL_Element*));
 
 /**
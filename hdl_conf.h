@@ -1,30 +1,55 @@
 #ifndef __HDL_CONF
 #define __HDL_CONF
 
-// Define HDL_CONF_16BIT_CHILD_COUNT if an element has more than 255 children
-// #define HDL_CONF_16BIT_CHILD_COUNT
-
-// Define HDL_CONF_STATIC_CHILDREN_COUNT <number> if you want to have the children 
-// in statically allocated array, uses more memory but doesn't need malloc
-#define HDL_CONF_STATIC_CHILDREN_COUNT 16
-
 // Define HDL_CONF_USE_KVP_ATTR if you want custom attributes
 // #define HDL_CONF_USE_KVP_ATTR
 
 // Max count of bindings
 #define HDL_CONF_MAX_BINDINGS   32
 
-// Max count of bound attributes
+// Max count of bound attributes per element
 #define HDL_CONF_MAX_ATTR_BINDINGS  8
 
 // Maximum preloaded image count
 #define HDL_CONF_MAX_PRELOADED_IMAGES 4
 
+// Default byte budget for lazily loaded bitmaps, see HDL_SetBitmapLoader
+#define HDL_CONF_BITMAP_CACHE_SIZE 4096
+
 // Maximum widget count
 #define HDL_CONF_MAX_WIDGETS 16
 
+// Maximum simultaneous animations
+#define HDL_CONF_MAX_ANIMATIONS 8
+
+// Cell size of the hit test grid in pixels
+#define HDL_CONF_HIT_CELL 16
+
 // Use binding copies for auto refresh
 #define HDL_CONF_BIND_COPIES
 
+// Keep a hash of each element for HDL_Rebuild to reuse unchanged elements, 4 bytes per element.
+// Without it HDL_Rebuild replaces the whole tree
+#define HDL_CONF_REBUILD
+
+// Maximum element nesting depth (root is depth 1). Build and render use a
+// fixed work stack of this many frames, deeper documents fail with HDL_ERR_DEPTH
+#define HDL_CONF_MAX_DEPTH 16
+
+// Size of the shared buffer used to format element content
+#define HDL_CONF_CONTENT_BUFFER_SIZE 256
+
+// Spans batched for a single f_spans call
+#define HDL_CONF_SPAN_BATCH 64
+
+// Visible list rows tracked for partial redraw, rows beyond are redrawn on every list change
+#define HDL_CONF_LIST_ROWS 16
+
+// Glyphs kept decoded for core fonts
+#define HDL_CONF_GLYPH_CACHE 16
+
+// Maximum ink runs of a cached glyph, more complex glyphs are decoded on every draw
+#define HDL_CONF_GLYPH_RUNS 24
+
 
 #endif
\ No newline at end of file